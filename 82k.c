@@ -3,7 +3,13 @@
 #include <stdlib.h>
 
 #include "bignum.h"
+#include "estimate.h"
+#include "leapfrog.h"
+#include "mitm.h"
+#include "pipeline.h"
+#include "search.h"
 #include "tests.h"
+#include "tune.h"
 
 char* limited_precision_base_conv(long int number, size_t base) {
     static char base_digits[] = {
@@ -31,107 +37,119 @@ char* limited_precision_base_conv(long int number, size_t base) {
     return buff;
 }
 
-char* unlimited_precision_base_conv(bignum *number, size_t base) {
-    static char base_digits[] = {
-        '0', '1', '2', '3', '4', '5', '6', '7',
-        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-    };
-    bignum work;
-    bignum_init(&work);
-    bignum_copy(&work, number);
-    // allocate enough to print binary:
-    char *buff = malloc((work.size * 8 + 1) * sizeof(char));
-    int *converted_number = malloc((work.size * 8) * sizeof(int));
-    int digit = 0;
-    // convert to the indicated base
-    while (!bignum_is_zero(&work)) {
-        bignum_div_mod_int(&work, base, &(converted_number[digit]));
-        ++digit;
+int main(int argc, char *argv[]) {
+    init_div_mod_int_lut();
+    char profile_path[1024];
+    tune_profile profile;
+    tune_profile_path(profile_path, sizeof(profile_path));
+    tune_profile_default(&profile);
+    tune_profile_load(&profile, profile_path);
+    if (argc > 1 && 0 == strcmp(argv[1], "-e")) {
+        eyeball_tests();
+        test();
+        return 0;
     }
-    // now print the result in reverse order
-    --digit;  // back up to last entry in the array
-    int i = 0;
-    while (digit >= 0) {
-        buff[i] = base_digits[converted_number[digit]];
-        --digit;
-        ++i;
+    if (argc > 1 && 0 == strcmp(argv[1], "-t")) {
+        test();
+        return 0;
     }
-    buff[i] = '\0';
-    bignum_free(&work);
-    free(converted_number);
-    return buff;
-}
-
-bool check_base(bignum *n, int base) {
-    bignum work;
-    bignum_init(&work);
-    bignum_copy(&work, n);
-    int converted_digit = 0;
-    while (!bignum_is_zero(&work)) {
-        bignum_div_mod_int(&work, base, &converted_digit);
-        if (converted_digit > 1) {
-            bignum_free(&work);
-            return false;
+    if (argc > 1 && 0 == strcmp(argv[1], "-p")) {
+        pipeline_opts opts;
+        pipeline_opts_default(&opts);
+        tune_pipeline_opts(&profile, &opts);
+        if (argc > 2) {
+            opts.depth = strtoul(argv[2], NULL, 10);
+        }
+        if (argc > 3) {
+            opts.batch = strtoul(argv[3], NULL, 10);
         }
+        if (opts.depth == 0 || opts.batch == 0) {
+            fprintf(stderr, "usage: %s -p [depth [batch]]\n", argv[0]);
+            return 1;
+        }
+        search_pipelined(&opts);
+        return 0;
     }
-    bignum_free(&work);
-    return true;
-}
-
-void search() {
-    bignum n5;
-    bignum n;
-    bignum tmp;
-    bignum_init(&n5);
-    bignum_init(&n);
-    bignum_init(&tmp);
-    int base_cap = 4;
-    bignum_from_int(&n5, 1);
-    int last_size = n5.size;
-    bignum_init_base_convert(40*8, 5);
-    while (n5.size < 4) {
-        bignum_base_convert(&n, &n5);
-        int base = base_cap;
-        while (base > 2) {
-            if (!check_base(&n, base)) {
-                break;
-            }
-            --base;
+    if (argc > 1 && 0 == strcmp(argv[1], "-m")) {
+        mitm_opts opts;
+        mitm_opts_default(&opts);
+        if (argc > 2) {
+            opts.bits = atoi(argv[2]);
+            opts.split = opts.bits / 2;
+        }
+        tune_mitm_opts(&profile, &opts);
+        if (argc > 3) {
+            opts.split = atoi(argv[3]);
         }
-        if (base == 2) {
-            bignum_base_convert(&tmp, &n5);
-            printf("covers all bases from 2 to %d: ", base_cap + 1);
-            bignum_print_int(&tmp);
+        if (argc > 4) {
+            opts.workers = atoi(argv[4]);
         }
-        bignum_inc(&n5);
-        if (n5.size > last_size) {
-            printf("b5: ");
-            bignum_dump(&n5);
-            bignum_base_convert(&tmp, &n5);
-            char* b = unlimited_precision_base_conv(&tmp, 10);
-            printf("b10: %s\n", b);
-            free(b);
-            last_size = n5.size;
+        if (opts.bits < 2 || opts.bits > 64 || opts.split < 1
+                || opts.split > 30 || opts.split >= opts.bits
+                || opts.workers < 1) {
+            fprintf(stderr, "usage: %s -m [bits [split [workers]]]\n", argv[0]);
+            return 1;
         }
+        search_mitm(&opts);
+        return 0;
     }
-    bignum_free_base_convert_lut();
-    bignum_free(&n5);
-    bignum_free(&n);
-    bignum_free(&tmp);
-}
-
-int main(int argc, char *argv[]) {
-    init_div_mod_int_lut();
-    if (argc > 1 && 0 == strcmp(argv[1], "-e")) {
-        eyeball_tests();
-        test();
+    if (argc > 1 && 0 == strcmp(argv[1], "-l")) {
+        search_opts opts;
+        search_opts_default(&opts);
+        if (argc > 2) {
+            opts.limit_bytes = strtoul(argv[2], NULL, 10);
+        }
+        if (opts.limit_bytes < 2 || opts.limit_bytes > SEARCH_MAX_LIMIT_BYTES) {
+            fprintf(stderr, "usage: %s -l [limit_bytes]\n", argv[0]);
+            return 1;
+        }
+        leapfrog_stats stats;
+        search_leapfrog(&opts, &stats);
         return 0;
     }
-    if (argc > 1 && 0 == strcmp(argv[1], "-t")) {
-        test();
+    if (argc > 1 && 0 == strcmp(argv[1], "-B")) {
+        bench_leapfrog();
+        return 0;
+    }
+    if (argc > 1 && 0 == strcmp(argv[1], "--estimate")) {
+        estimate_opts opts;
+        estimate_opts_default(&opts);
+        if (argc > 2) {
+            opts.limit_bytes = strtoul(argv[2], NULL, 10);
+        }
+        if (argc > 3) {
+            opts.workers = atoi(argv[3]);
+        }
+        if (argc > 4) {
+            opts.samples = strtoul(argv[4], NULL, 10);
+        }
+        if (opts.limit_bytes < 2 || opts.limit_bytes > SEARCH_MAX_LIMIT_BYTES
+                || opts.workers < 1 || opts.samples < 1) {
+            fprintf(stderr, "usage: %s --estimate [limit_bytes [workers "
+                    "[samples]]]\n", argv[0]);
+            return 1;
+        }
+        opts.mitm.bits = 8 * (opts.limit_bytes - 1);
+        opts.mitm.split = opts.mitm.bits / 2;
+        tune_mitm_opts(&profile, &opts.mitm);
+        estimate e;
+        estimate_run(&opts, &e);
+        estimate_print(&opts, &e, stdout);
+        return 0;
+    }
+    if (argc > 1 && 0 == strcmp(argv[1], "--autotune")) {
+        tune_profile_default(&profile);
+        autotune(&profile, stdout);
+        if (!tune_profile_save(&profile, profile_path)) {
+            fprintf(stderr, "can't write %s\n", profile_path);
+            return 1;
+        }
+        printf("saved to %s\n", profile_path);
         return 0;
     }
-    search();
+    search_opts opts;
+    search_opts_default(&opts);
+    search_run(&opts);
     return 0;
 }
 
@@ -1,18 +1,19 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include "bignum.h"
 
-static size_t mul_lut_size = 0;
-static bignum *mul_lut = NULL;
-
+// n->data is NULL if the allocation fails
 void bignum_init_cap(bignum *n, size_t cap) {
     n->data = malloc(cap * sizeof(uint8_t));
     n->size = 0;
-    n->cap = cap;
+    n->cap = n->data ? cap : 0;
     n->negative = false;
 }
 
@@ -25,6 +26,21 @@ void bignum_resize(bignum *n) {
     n->data = realloc(n->data, n->cap);
 }
 
+// Grows n to at least cap bytes. Returns false if that fails, n is
+// unchanged then.
+bool bignum_reserve(bignum *n, size_t cap) {
+    if (n->cap >= cap) {
+        return true;
+    }
+    uint8_t *data = realloc(n->data, cap);
+    if (!data) {
+        return false;
+    }
+    n->data = data;
+    n->cap = cap;
+    return true;
+}
+
 void bignum_free(bignum *n) {
     n->size = 0;
     n->cap = 0;
@@ -32,7 +48,7 @@ void bignum_free(bignum *n) {
     n->data = NULL;
 }
 
-void bignum_copy(bignum *dest, bignum *src) {
+void bignum_copy(bignum *dest, bignum const *src) {
     dest->cap = src->cap;
     dest->size = src->size;
     free(dest->data);
@@ -40,7 +56,7 @@ void bignum_copy(bignum *dest, bignum *src) {
     memcpy(dest->data, src->data, src->cap);
 }
 
-bool bignum_is_zero(bignum *n) {
+bool bignum_is_zero(bignum const *n) {
     return n->size == 0 || (n->size == 1 && n->data[0] == 0);
 }
 
@@ -132,6 +148,52 @@ void bignum_from_int(bignum *n, int s) {
     }
 }
 
+void bignum_from_u64(bignum *n, uint64_t s) {
+    assert(n->cap >= 8);
+    for (int i = 0; i < 8; ++i) {
+        n->data[i] = (s >> (i * 8)) & 0xff;
+    }
+    n->size = 8;
+    n->negative = false;
+    while (n->size > 1 && n->data[n->size - 1] == 0) {
+        --n->size;
+    }
+    if (n->data[0] == 0 && n->size == 1) {
+        n->size = 0;
+    }
+}
+
+// n from nlimbs 64 bit limbs, least significant first
+void bignum_from_limbs(bignum *n, uint64_t const *limbs, size_t nlimbs) {
+    while (n->cap < nlimbs * 8) {
+        bignum_resize(n);
+    }
+    for (size_t i = 0; i < nlimbs * 8; ++i) {
+        n->data[i] = (limbs[i / 8] >> (i % 8 * 8)) & 0xff;
+    }
+    n->size = nlimbs * 8;
+    n->negative = false;
+    while (n->size > 0 && n->data[n->size - 1] == 0) {
+        --n->size;
+    }
+}
+
+// Writes n into at most nlimbs limbs, zero filled, and returns the number
+// of limbs n takes; when that is more than nlimbs nothing is written
+size_t bignum_to_limbs(bignum const *n, uint64_t *limbs, size_t nlimbs) {
+    size_t used = (n->size + 7) / 8;
+    if (used > nlimbs) {
+        return used;
+    }
+    for (size_t i = 0; i < nlimbs; ++i) {
+        limbs[i] = 0;
+    }
+    for (size_t i = 0; i < n->size; ++i) {
+        limbs[i / 8] |= (uint64_t)n->data[i] << (i % 8 * 8);
+    }
+    return used;
+}
+
 void bignum_inc(bignum *n) {
     bool carry = false;
     int i = 0;
@@ -256,24 +318,32 @@ void bignum_mul_int(bignum *a, unsigned int b) {
     bignum_free(&tmp);
 }
 
-bool bignum_lte(bignum *a, bignum *b) {
-    if (a->size < b->size) {
-        return true;
-    } else if (a->size > b->size) {
-        return false;
-    }
-    for (int i = a->size - 1; i >= 0; --i) {
-        if (a->data[i] > b->data[i]) {
-            return false;
+// Returns -1, 0 or 1 as a is less than, equal to or greater than b. Both
+// must be normalized, i.e. without leading zero bytes.
+int bignum_cmp(bignum const *a, bignum const *b) {
+    size_t as = bignum_is_zero(a) ? 0 : a->size;
+    size_t bs = bignum_is_zero(b) ? 0 : b->size;
+    if (as != bs) {
+        return as < bs ? -1 : 1;
+    }
+    for (int i = as - 1; i >= 0; --i) {
+        if (a->data[i] != b->data[i]) {
+            return a->data[i] < b->data[i] ? -1 : 1;
         }
     }
-    return true;
+    return 0;
+}
+
+bool bignum_lte(bignum *a, bignum *b) {
+    return bignum_cmp(a, b) <= 0;
 }
 
 #define LUTSZ 10000
 #define NDIVISORS 11
-unsigned int lut[NDIVISORS][LUTSZ][2];
-void init_div_mod_int_lut() {
+static unsigned int lut[NDIVISORS][LUTSZ][2];
+static pthread_once_t lut_once = PTHREAD_ONCE_INIT;
+
+static void fill_div_mod_int_lut() {
     for (int b = 2; b < NDIVISORS; ++b) {
         for (unsigned int temp = 0; temp < LUTSZ; ++temp) {
             lut[b][temp][0] = temp / b;
@@ -282,6 +352,12 @@ void init_div_mod_int_lut() {
     }
 }
 
+// The table is filled once per process and is read-only afterwards, so
+// bignum_div_mod_int can be called from any thread.
+void init_div_mod_int_lut() {
+    pthread_once(&lut_once, fill_div_mod_int_lut);
+}
+
 // Algorithm taken from:
 // http://stackoverflow.com/questions/10522379/bignum-division-with-an-unsigned-8-bit-integer-c
 void bignum_div_mod_int(bignum *a, int b, int *remainder) {
@@ -307,6 +383,31 @@ void bignum_div_mod_int(bignum *a, int b, int *remainder) {
     }
 }
 
+// a /= d, returns a % d
+uint32_t bignum_div_mod_u32(bignum *a, uint32_t d) {
+    assert(d > 0);
+    uint64_t r = 0;
+    for (int i = a->size - 1; i >= 0; --i) {
+        uint64_t cur = (r << 8) | a->data[i];
+        a->data[i] = cur / d;
+        r = cur % d;
+    }
+    while (a->size > 0 && a->data[a->size - 1] == 0) {
+        --a->size;
+    }
+    return r;
+}
+
+// Returns a % m without modifying a
+uint64_t bignum_mod_u64(bignum const *a, uint64_t m) {
+    assert(m > 0 && m <= 0xffffffffu);
+    uint64_t r = 0;
+    for (int i = a->size - 1; i >= 0; --i) {
+        r = ((r << 8) | a->data[i]) % m;
+    }
+    return r;
+}
+
 // remainder is optional
 void bignum_div_mod(bignum *a, bignum *b, bignum *remainder) {
     int i = a->size;
@@ -345,62 +446,243 @@ void bignum_mod(bignum *a, bignum *b) {
 }
 
 #define SUMSZ 8
-bignum sum_lut[SUMSZ][256]; // SUMSZ*256 partial sums for SUMSZ bytes, 256 values each
 
-void bignum_init_base_convert(size_t size, int base) {
-    bignum multiplier;
-    bignum_init(&multiplier);
-    bignum_from_int(&multiplier, 1);
-    mul_lut = malloc(size * sizeof(bignum));
-    mul_lut_size = size;
-    for (int i = 0; i < size; ++i) {
-        bignum_init(&mul_lut[i]);
-        bignum_copy(&mul_lut[i], &multiplier);
-        bignum_mul_int(&multiplier, base);
+// Tables for converting from base 'base', immutable once bignum_base_ctx_new
+// returns, so one context can be shared by any number of threads.
+//
+// Both tables live in one cache line aligned slab: first the partial sums,
+// which are on the hot path of bignum_base_convert, then the powers. Each
+// region has a fixed stride sized to its longest entry, and the bignums in
+// mul_lut and sum_lut are views into it that must not be bignum_free()d.
+struct _bignum_base_ctx {
+    int base;
+    size_t mul_lut_size;
+    bignum *mul_lut;
+    bignum sum_lut[SUMSZ][256]; // SUMSZ*256 partial sums for SUMSZ bytes, 256 values each
+    uint8_t *slab;
+    size_t slab_bytes;
+};
+
+#define LUT_ALIGN 64
+#ifdef LUT_HUGE_PAGES
+#define LUT_SLAB_ALIGN (2 * 1024 * 1024)
+#else
+#define LUT_SLAB_ALIGN LUT_ALIGN
+#endif
+
+static size_t lut_stride(size_t len) {
+    return (len + 7) & ~(size_t)7;
+}
+
+static void lut_view(bignum *view, uint8_t *at, bignum *src, size_t stride) {
+    memcpy(at, src->data, src->size);
+    memset(at + src->size, 0, stride - src->size);
+    view->data = at;
+    view->size = src->size;
+    view->cap = stride;
+    view->negative = false;
+}
+
+// max_len is the number of base 'base' digits the powers table covers.
+// Returns NULL if an allocation fails; every buffer is sized up front so
+// that no bignum has to grow on the way.
+bignum_base_ctx *bignum_base_ctx_try_new(int base, size_t max_len) {
+    assert(base >= 2 && max_len >= SUMSZ * 8);
+    init_div_mod_int_lut();
+    // base**i takes at most i * bits / 8 + 1 bytes
+    size_t bits = 0;
+    for (int b = base - 1; b != 0; b >>= 1) {
+        ++bits;
+    }
+    bignum power;
+    bignum_init_cap(&power, max_len * bits / 8 + 8);
+    if (!power.data) {
+        return NULL;
+    }
+
+    // the first pass only measures the two longest entries
+    size_t sum_size = 0;
+    size_t mul_size = 0;
+    bignum_from_int(&power, 1);
+    for (size_t i = 0; i < max_len; ++i) {
+        if (i == SUMSZ * 8 - 1) {
+            sum_size = power.size;
+        }
+        mul_size = power.size;
+        bignum_mul_add_int(&power, base, 0);
     }
-    bignum_free(&multiplier);
 
+    // a sum of base**0 .. base**(m-1) is shorter than base**m plus a byte
+    size_t sum_stride = lut_stride(sum_size + 1);
+    size_t mul_stride = lut_stride(mul_size);
+    size_t sum_bytes = SUMSZ * 256 * sum_stride;
+    size_t slab_bytes = sum_bytes + max_len * mul_stride;
+    slab_bytes = (slab_bytes + LUT_SLAB_ALIGN - 1) & ~(size_t)(LUT_SLAB_ALIGN - 1);
+    bignum_base_ctx *ctx = calloc(1, sizeof(bignum_base_ctx));
     bignum sum;
-    bignum_init(&sum);
+    bignum_init_cap(&sum, sum_stride + 1);
+    if (!ctx || !sum.data
+            || !(ctx->mul_lut = malloc(max_len * sizeof(bignum)))
+            || posix_memalign((void**)&ctx->slab, LUT_SLAB_ALIGN,
+                              slab_bytes) != 0) {
+        bignum_free(&power);
+        bignum_free(&sum);
+        bignum_base_ctx_free(ctx);
+        return NULL;
+    }
+    ctx->base = base;
+    ctx->slab_bytes = slab_bytes;
+#if defined(LUT_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+    madvise(ctx->slab, slab_bytes, MADV_HUGEPAGE);
+#endif
+
+    ctx->mul_lut_size = max_len;
+    bignum_from_int(&power, 1);
+    for (size_t i = 0; i < max_len; ++i) {
+        lut_view(&ctx->mul_lut[i], ctx->slab + sum_bytes + i * mul_stride,
+                 &power, mul_stride);
+        bignum_mul_add_int(&power, base, 0);
+    }
+    bignum_free(&power);
+
     for (int i = 0; i < SUMSZ; ++i) {
         for (int j = 0; j < 256; ++j) {
             int m = i*8;
             bignum_from_int(&sum, 0);
             for (uint8_t mask = 1; mask != 0; mask <<= 1) {
                 if (j & mask) {
-                    bignum_add(&sum, &mul_lut[m]);
+                    bignum_add(&sum, &ctx->mul_lut[m]);
                 }
                 ++m;
             }
-            bignum_init(&sum_lut[i][j]);
-            bignum_copy(&sum_lut[i][j], &sum);
+            assert(sum.size <= sum_stride);
+            lut_view(&ctx->sum_lut[i][j],
+                     ctx->slab + (i * 256 + j) * sum_stride, &sum, sum_stride);
         }
     }
     bignum_free(&sum);
+    return ctx;
 }
 
-void bignum_free_base_convert_lut() {
-    for (int i = 0; i < mul_lut_size; ++i) {
-        bignum_free(&mul_lut[i]);
+bignum_base_ctx *bignum_base_ctx_new(int base, size_t max_len) {
+    bignum_base_ctx *ctx = bignum_base_ctx_try_new(base, max_len);
+    if (!ctx) {
+        fprintf(stderr, "can't allocate the base %d tables\n", base);
+        exit(1);
     }
-    free(mul_lut);
-    mul_lut = NULL;
-    mul_lut_size = 0;
-    for (int i = 0; i < SUMSZ; ++i) {
-        for (int j = 0; j < 256; ++j) {
-            bignum_free(&sum_lut[i][j]);
-        }
+    return ctx;
+}
+
+void bignum_base_ctx_free(bignum_base_ctx *ctx) {
+    if (!ctx) {
+        return;
     }
+    free(ctx->mul_lut);
+    free(ctx->slab);
+    free(ctx);
+}
+
+int bignum_base_ctx_base(bignum_base_ctx const *ctx) {
+    return ctx->base;
+}
+
+size_t bignum_base_ctx_size(bignum_base_ctx const *ctx) {
+    return ctx->mul_lut_size;
+}
+
+// Memory the context holds, slab included
+size_t bignum_base_ctx_bytes(bignum_base_ctx const *ctx) {
+    return sizeof(*ctx) + ctx->mul_lut_size * sizeof(bignum) + ctx->slab_bytes;
+}
+
+// base**i
+bignum const *bignum_base_ctx_power(bignum_base_ctx const *ctx, size_t i) {
+    assert(i < ctx->mul_lut_size);
+    return &ctx->mul_lut[i];
 }
 
-// assign n from s, treat s as being in base 'base'
-void bignum_base_convert(bignum *n, bignum* s) {
+// assign n from s, treat s as being in base ctx->base
+void bignum_base_convert(bignum_base_ctx const *ctx, bignum *n, bignum* s) {
+    assert(s->size <= SUMSZ);
     bignum_from_int(n, 0);
     for (int i = 0; i < s->size; ++i) {
-        bignum_add(n, &sum_lut[i][s->data[i]]);
+        bignum_add(n, (bignum*)&ctx->sum_lut[i][s->data[i]]);
     }
 }
 
+// Assigns r the smallest number >= x whose base ctx->base digits are all
+// 0 or 1. If the highest digit above 1 is at position i, the digits above
+// it are read as a binary number and incremented: the lowest 0 above i
+// becomes a 1, and every digit below it becomes 0.
+//
+// The digits are peeled off a chunk of bignum_chunk_pow at a time. work and
+// digits are the caller's scratch, grown as needed and best kept across
+// calls. Returns false, leaving r alone, if r needs a power of the base
+// past the context's table or the scratch can't grow.
+bool bignum_next_ge(bignum_base_ctx const *ctx, bignum *r, bignum const *x,
+                    bignum *work, bignum *digits) {
+    int base = ctx->base;
+    int chunk_digits;
+    uint32_t chunk = bignum_chunk_pow(base, &chunk_digits);
+    // a byte holds at most 8 digits, the top chunk adds leading zeros
+    if (!bignum_reserve(work, x->size)
+            || !bignum_reserve(digits, x->size * 8 + chunk_digits)) {
+        return false;
+    }
+    memcpy(work->data, x->data, x->size);
+    work->size = x->size;
+    size_t ndigits = 0;
+    while (!bignum_is_zero(work)) {
+        uint32_t rem = bignum_div_mod_u32(work, chunk);
+        for (int i = 0; i < chunk_digits; ++i) {
+            digits->data[ndigits++] = rem % base;
+            rem /= base;
+        }
+    }
+    while (ndigits > 0 && digits->data[ndigits - 1] == 0) {
+        --ndigits;
+    }
+    size_t bad = ndigits;
+    for (size_t i = ndigits; i > 0; --i) {
+        if (digits->data[i - 1] > 1) {
+            bad = i - 1;
+            break;
+        }
+    }
+    if (bad == ndigits) {
+        if (!bignum_reserve(r, x->size > 4 ? x->size : 4)) {
+            return false;
+        }
+        memcpy(r->data, x->data, x->size);
+        if (x->size < 4) { // bignum_to_int reads 4 bytes
+            memset(r->data + x->size, 0, 4 - x->size);
+        }
+        r->size = x->size;
+        r->negative = false;
+        return true;
+    }
+    size_t carry = bad + 1;
+    while (carry < ndigits && digits->data[carry] == 1) {
+        ++carry;
+    }
+    size_t top = carry > ndigits - 1 ? carry : ndigits - 1;
+    if (top >= ctx->mul_lut_size) {
+        return false;
+    }
+    // the sum stays below base**(top + 1), at most a byte longer
+    if (!bignum_reserve(r, ctx->mul_lut[top].size + 4)) {
+        return false;
+    }
+    bignum_from_int(r, 0);
+    bignum_add(r, &ctx->mul_lut[carry]);
+    for (size_t i = carry + 1; i < ndigits; ++i) {
+        if (digits->data[i]) {
+            bignum_add(r, &ctx->mul_lut[i]);
+        }
+    }
+    return true;
+}
+
 /*
 Examples:
 82000 (base 3) = 11011111001 =
@@ -410,19 +692,98 @@ Examples:
 0*5**0 + 0*5**1 + 0*5**2 + 1*5**3 + 1*5**4 + 1*5**5 + 0*5**6 + 1*5**7
 */
 void bignum_from_string_binary(bignum *n, char const* s, size_t base) {
-    char const *end_of_s = s + strlen(s) - 1;
+    bool ok = bignum_from_string(n, s, strlen(s), base);
+    assert(ok);
+    (void)ok;
+}
+
+// a = a * mul + add, in place
+void bignum_mul_add_int(bignum *a, uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (size_t i = 0; i < a->size; ++i) {
+        carry += (uint64_t)a->data[i] * mul;
+        a->data[i] = carry & 0xff;
+        carry >>= 8;
+    }
+    while (carry != 0) {
+        if (a->size >= a->cap) {
+            bignum_resize(a);
+        }
+        a->data[a->size++] = carry & 0xff;
+        carry >>= 8;
+    }
+}
+
+static int digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+    }
+    return 36;
+}
+
+// Parses len digits of s in base 2..36. Digits are consumed in chunks of k,
+// with base**k the largest power that fits in 32 bits, so each chunk costs
+// one in-place multiply-add over n and nothing is allocated unless n has to
+// grow. Returns false on a digit that is not valid in base.
+bool bignum_from_string(bignum *n, char const *s, size_t len, size_t base) {
+    assert(base >= 2 && base <= 36);
+    int k;
+    bignum_chunk_pow(base, &k);
     bignum_from_int(n, 0);
-    bignum multiplier;
-    bignum_init(&multiplier);
-    bignum_from_int(&multiplier, 1);
-    while (end_of_s != s) {
-        assert((*end_of_s == '1') || (*end_of_s == '0'));
-        if (*end_of_s == '1') {
-            bignum_add(n, &multiplier);
+    // the first chunk takes the odd digits so that the rest are all full
+    size_t take = len % k ? len % k : k;
+    size_t i = 0;
+    while (i < len) {
+        uint32_t acc = 0;
+        uint32_t pow = 1;
+        for (size_t end = i + take; i < end; ++i) {
+            int d = digit_value(s[i]);
+            if ((size_t)d >= base) {
+                return false;
+            }
+            acc = acc * base + d;
+            pow *= base;
+        }
+        bignum_mul_add_int(n, pow, acc);
+        take = k;
+    }
+    return true;
+}
+
+// Parses the newline separated lines of buf (an mmapped file, say) into
+// out[0], out[1], ... which the caller has already initialized; they are
+// only reallocated if a number does not fit. Blank lines and a trailing
+// '\r' are skipped. Stops when out is full or at a malformed line and
+// stores the offset where it stopped in *end, so that the caller can
+// resume or report the line. Returns the number of bignums parsed.
+size_t bignum_from_string_batch(bignum *out, size_t max, char const *buf,
+                                size_t len, size_t base, size_t *end) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < len && count < max) {
+        char const *nl = memchr(buf + pos, '\n', len - pos);
+        size_t line_end = nl ? (size_t)(nl - buf) : len;
+        size_t next = nl ? line_end + 1 : len;
+        size_t line_len = line_end - pos;
+        if (line_len > 0 && buf[line_end - 1] == '\r') {
+            --line_len;
         }
-        bignum_mul_int(&multiplier, base);
-        --end_of_s;
+        if (line_len > 0) {
+            if (!bignum_from_string(&out[count], buf + pos, line_len, base)) {
+                break;
+            }
+            ++count;
+        }
+        pos = next;
+    }
+    if (end) {
+        *end = pos;
     }
-    bignum_add(n, &multiplier);
-    bignum_free(&multiplier);
+    return count;
 }
@@ -0,0 +1,115 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "cascade.h"
+#include "timing.h"
+
+void cascade_init(cascade *c, uint64_t reorder_period) {
+    memset(c, 0, sizeof(*c));
+    c->reorder_period = reorder_period;
+    c->until_reorder = reorder_period;
+    // the cheapest filters run in a few ns, less than reading the clock
+    c->clock_ns = ~(uint64_t)0;
+    for (int i = 0; i < 16; ++i) {
+        uint64_t start = timing_now_ns();
+        uint64_t took = timing_now_ns() - start;
+        if (took < c->clock_ns) {
+            c->clock_ns = took;
+        }
+    }
+}
+
+void cascade_add(cascade *c, char const *name, filter_fn fn, void const *arg) {
+    assert(c->nfilters < CASCADE_MAX_FILTERS);
+    filter *f = &c->filters[c->nfilters];
+    memset(f, 0, sizeof(*f));
+    f->name = name;
+    f->fn = fn;
+    f->arg = arg;
+    c->order[c->nfilters] = c->nfilters;
+    ++c->nfilters;
+}
+
+size_t cascade_run(cascade *c, void *candidates, size_t count) {
+    c->candidates += count;
+    if (c->reorder_period && c->until_reorder <= count) {
+        c->until_reorder = c->reorder_period;
+        cascade_reorder(c);
+    } else {
+        c->until_reorder -= count;
+    }
+    bool sampled = (c->batches++ & CASCADE_SAMPLE_MASK) == 0;
+    for (int i = 0; i < c->nfilters && count > 0; ++i) {
+        filter *f = &c->filters[c->order[i]];
+        size_t passed;
+        f->calls += count;
+        if (sampled) {
+            uint64_t start = timing_now_ns();
+            passed = f->fn(candidates, count, f->arg);
+            uint64_t took = timing_now_ns() - start;
+            f->ns += took > c->clock_ns ? took - c->clock_ns : 0;
+            f->timed += count;
+        } else {
+            passed = f->fn(candidates, count, f->arg);
+        }
+        f->passes += passed;
+        count = passed;
+    }
+    return count;
+}
+
+double cascade_pass_rate(filter const *f) {
+    return f->calls ? (double)f->passes / f->calls : 0;
+}
+
+double cascade_cost_ns(filter const *f) {
+    return f->timed ? (double)f->ns / f->timed : 0;
+}
+
+// Filters that have not been timed yet rank first so that they get measured
+static double cascade_rank(filter const *f) {
+    if (f->timed == 0) {
+        return 0;
+    }
+    double reject = 1 - cascade_pass_rate(f);
+    if (reject <= 0) {
+        return 1e300;
+    }
+    return cascade_cost_ns(f) / reject;
+}
+
+void cascade_reorder(cascade *c) {
+    double rank[CASCADE_MAX_FILTERS];
+    for (int i = 0; i < c->nfilters; ++i) {
+        rank[i] = cascade_rank(&c->filters[i]);
+    }
+    // insertion sort, stable so that ties keep their current order
+    for (int i = 1; i < c->nfilters; ++i) {
+        int f = c->order[i];
+        int j = i - 1;
+        while (j >= 0 && rank[c->order[j]] > rank[f]) {
+            c->order[j + 1] = c->order[j];
+            --j;
+        }
+        c->order[j + 1] = f;
+    }
+    ++c->reorders;
+}
+
+void cascade_report(cascade const *c, FILE *out) {
+    fprintf(out, "cascade: %llu candidates, %llu reorders, order:",
+            (unsigned long long)c->candidates,
+            (unsigned long long)c->reorders);
+    for (int i = 0; i < c->nfilters; ++i) {
+        fprintf(out, " %s", c->filters[c->order[i]].name);
+    }
+    fprintf(out, "\n");
+    for (int i = 0; i < c->nfilters; ++i) {
+        filter const *f = &c->filters[c->order[i]];
+        fprintf(out, "  %-8s calls %llu pass %.6f cost %.1fns\n", f->name,
+                (unsigned long long)f->calls, cascade_pass_rate(f),
+                cascade_cost_ns(f));
+    }
+}
@@ -0,0 +1,247 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "bignum.h"
+#include "estimate.h"
+#include "msd.h"
+#include "timing.h"
+
+#define ESTIMATE_BATCH 256
+#define NS_PER_HOUR 3.6e12
+
+// xorshift64, the samples only need to avoid lining up with the bytes
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static size_t bit_length(bignum const *n) {
+    if (n->size == 0) {
+        return 0;
+    }
+    size_t bits = n->size * 8;
+    for (uint8_t top = n->data[n->size - 1]; !(top & 0x80); top <<= 1) {
+        --bits;
+    }
+    return bits;
+}
+
+void estimate_opts_default(estimate_opts *opts) {
+    opts->limit_bytes = SEARCH_LIMIT_BYTES;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    opts->workers = ncpu > 0 ? ncpu : 1;
+    opts->samples = ESTIMATE_DEFAULT_SAMPLES;
+    mitm_opts_default(&opts->mitm);
+    opts->mitm.bits = 8 * (opts->limit_bytes - 1);
+    opts->mitm.split = opts->mitm.bits / 2;
+}
+
+// Walks the aligned blocks around pattern p the way the fixed width search
+// does, from the widest down until one is rejected, and counts the levels
+// it tests in reached[k]. True if a block was rejected. tops[k] is the n
+// of a pattern of k bytes of 255.
+static bool block_skipped(bignum_base_ctx const *ctx, int base_cap,
+                          msd_table const *tables, bignum const *tops,
+                          uint64_t p, int n5_bytes, uint64_t *reached) {
+    bignum n5;
+    bignum lo;
+    bignum_init(&n5);
+    bignum_init(&lo);
+    bool skipped = false;
+    for (int k = n5_bytes - 1; k > 0 && !skipped; --k) {
+        bignum_from_u64(&n5, p & ~(((uint64_t)1 << (8 * k)) - 1));
+        bignum_base_convert(ctx, &lo, &n5);
+        long double low = msd_from_bignum(&lo);
+        bignum_add(&lo, (bignum*)&tops[k]);
+        long double high = msd_from_bignum(&lo);
+        ++reached[k];
+        for (int base = base_cap; base > 2 && !skipped; --base) {
+            skipped = msd_block_rejects(&tables[base], low, high,
+                                        MSD_ROUNDING_ERROR);
+        }
+    }
+    bignum_free(&n5);
+    bignum_free(&lo);
+    return skipped;
+}
+
+// Samples spread evenly over the n5 of n5_bytes bytes, each jittered
+// within its share of the range
+static void estimate_row_run(bignum_base_ctx const *ctx, int base_cap,
+                             msd_table const *tables, bignum const *tops,
+                             size_t samples, estimate_row *row) {
+    int bytes = row->n5_bytes;
+    assert(bytes < SEARCH_MAX_LIMIT_BYTES);
+    uint64_t first = bytes == 1 ? 1 : (uint64_t)1 << (8 * (bytes - 1));
+    uint64_t last = ((uint64_t)1 << (8 * bytes)) - 1;
+    uint64_t span = last - first + 1;
+    size_t count = span < samples ? span : samples;
+    row->candidates = span;
+
+    uint64_t *patterns = malloc(count * sizeof(uint64_t));
+    bignum *n = malloc(count * sizeof(bignum));
+    uint64_t state = 0x9e3779b97f4a7c15u ^ bytes;
+    for (size_t i = 0; i < count; ++i) {
+        long double jitter = (next_random(&state) >> 11) / 9007199254740992.0L;
+        uint64_t offset = (uint64_t)((i + jitter) * span / count);
+        patterns[i] = first + (offset < span ? offset : span - 1);
+        bignum_init(&n[i]);
+    }
+
+    bignum n5;
+    bignum_init(&n5);
+    uint64_t start = timing_now_ns();
+    for (size_t i = 0; i < count; ++i) {
+        bignum_from_u64(&n5, patterns[i]);
+        bignum_base_convert(ctx, &n[i], &n5);
+    }
+    row->convert_ns = (double)(timing_now_ns() - start) / count;
+
+    bignum top;
+    bignum_init(&top);
+    bignum_from_u64(&n5, last);
+    bignum_base_convert(ctx, &top, &n5);
+    row->n_bits = bit_length(&top);
+    bignum_free(&top);
+    bignum_free(&n5);
+
+    cascade_init(&row->filters, CASCADE_DEFAULT_PERIOD);
+    search_add_bignum_filters(&row->filters, base_cap, tables);
+    start = timing_now_ns();
+    for (size_t i = 0; i < count; i += ESTIMATE_BATCH) {
+        size_t batch = count - i < ESTIMATE_BATCH ? count - i : ESTIMATE_BATCH;
+        cascade_run(&row->filters, &n[i], batch);
+    }
+    row->check_ns = (double)(timing_now_ns() - start) / count;
+
+    size_t skipped = 0;
+    uint64_t reached[SEARCH_MAX_LIMIT_BYTES] = {0};
+    start = timing_now_ns();
+    for (size_t i = 0; i < count; ++i) {
+        skipped += block_skipped(ctx, base_cap, tables, tops, patterns[i],
+                                 bytes, reached);
+    }
+    uint64_t tests = 0;
+    row->block_tests = 0;
+    for (int k = 1; k < bytes; ++k) {
+        // a level k block is tested once if the sample in it got that far,
+        // and there are span / 256**k of them
+        tests += reached[k];
+        row->block_tests += (double)reached[k] / count
+            * (span >> (8 * k));
+    }
+    row->block_ns = tests ? (double)(timing_now_ns() - start) / tests : 0;
+    row->skipped = (double)skipped / count;
+
+    for (size_t i = 0; i < count; ++i) {
+        bignum_free(&n[i]);
+    }
+    free(n);
+    free(patterns);
+}
+
+// Times the candidates of every n5 length below opts->limit_bytes and
+// extrapolates to the whole range. The timings are those of the bignum
+// engines; the fixed width search does the same work on narrower numbers,
+// so for it cpu_hours_skipping is an upper bound.
+void estimate_run(estimate_opts const *opts, estimate *e) {
+    assert(opts->limit_bytes >= 2
+           && opts->limit_bytes <= SEARCH_MAX_LIMIT_BYTES);
+    assert(opts->samples > 0 && opts->workers > 0);
+    int base_cap = 4;
+    // the tables search_run builds before its first candidate: the base 5
+    // context, the leading digit tables and a sums row per byte of n5
+    uint64_t start = timing_now_ns();
+    bignum_base_ctx *ctx = bignum_base_ctx_new(5, 40*8);
+    msd_table tables[SEARCH_MAX_BASE + 1];
+    search_msd_tables_init(tables, base_cap);
+    bignum n5;
+    bignum sum;
+    bignum_init(&n5);
+    bignum_init(&sum);
+    for (int i = 0; i + 1 < opts->limit_bytes; ++i) {
+        for (int j = 0; j < 256; ++j) {
+            bignum_from_u64(&n5, (uint64_t)j << (8 * i));
+            bignum_base_convert(ctx, &sum, &n5);
+        }
+    }
+    bignum_free(&sum);
+    e->setup_ns = timing_now_ns() - start;
+
+    bignum tops[SEARCH_MAX_LIMIT_BYTES];
+    for (int k = 0; k < opts->limit_bytes; ++k) {
+        bignum_init(&tops[k]);
+        bignum_from_u64(&n5, k ? ((uint64_t)1 << (8 * k)) - 1 : 0);
+        bignum_base_convert(ctx, &tops[k], &n5);
+    }
+    bignum_free(&n5);
+
+    e->nrows = opts->limit_bytes - 1;
+    e->cpu_hours = e->setup_ns / NS_PER_HOUR;
+    e->cpu_hours_skipping = e->cpu_hours;
+    for (int i = 0; i < e->nrows; ++i) {
+        estimate_row *row = &e->rows[i];
+        row->n5_bytes = i + 1;
+        estimate_row_run(ctx, base_cap, tables, tops, opts->samples, row);
+        double per_candidate = row->convert_ns + row->check_ns;
+        double left = row->candidates * (1 - row->skipped);
+        e->cpu_hours += row->candidates * per_candidate / NS_PER_HOUR;
+        e->cpu_hours_skipping += (left * per_candidate
+            + row->block_tests * row->block_ns) / NS_PER_HOUR;
+    }
+    // a shard of the range still builds all of the tables
+    double setup_hours = e->setup_ns / NS_PER_HOUR;
+    e->wall_hours = (e->cpu_hours_skipping - setup_hours) / opts->workers
+        + setup_hours;
+
+    // what search_run and search_mitm hold on to
+    bignum const *top = bignum_base_ctx_power(ctx, 8 * (opts->limit_bytes - 1));
+    size_t bits = top->size * 8;
+    e->width = bits <= 128 ? 128 : bits <= 192 ? 192 : bits <= 256 ? 256 : 0;
+    e->table_bytes = bignum_base_ctx_bytes(ctx)
+        + (base_cap - 2) * SEARCH_MSD_POWERS * 2 * sizeof(long double)
+        + (opts->limit_bytes - 1) * 256 * e->width / 8;
+    e->mitm_table_bytes = mitm_table_bytes(&opts->mitm);
+
+    for (int k = 0; k < opts->limit_bytes; ++k) {
+        bignum_free(&tops[k]);
+    }
+    search_msd_tables_free(tables, base_cap);
+    bignum_base_ctx_free(ctx);
+}
+
+// One key=value per line, like the tuning profile
+void estimate_print(estimate_opts const *opts, estimate const *e, FILE *out) {
+    fprintf(out, "limit_bytes=%zu\n", opts->limit_bytes);
+    fprintf(out, "workers=%d\n", opts->workers);
+    fprintf(out, "samples=%zu\n", opts->samples);
+    fprintf(out, "width=%zu\n", e->width);
+    for (int i = 0; i < e->nrows; ++i) {
+        estimate_row const *row = &e->rows[i];
+        char const *fmt = "n5_bytes.%d.%s=%.6g\n";
+        fprintf(out, "n5_bytes.%d.n_bits=%zu\n", row->n5_bytes, row->n_bits);
+        fprintf(out, fmt, row->n5_bytes, "candidates", row->candidates);
+        fprintf(out, fmt, row->n5_bytes, "skipped", row->skipped);
+        fprintf(out, fmt, row->n5_bytes, "convert_ns", row->convert_ns);
+        fprintf(out, fmt, row->n5_bytes, "check_ns", row->check_ns);
+        fprintf(out, fmt, row->n5_bytes, "block_tests", row->block_tests);
+        fprintf(out, fmt, row->n5_bytes, "block_ns", row->block_ns);
+        for (int j = 0; j < row->filters.nfilters; ++j) {
+            filter const *f = &row->filters.filters[row->filters.order[j]];
+            fprintf(out, "n5_bytes.%d.pass.%s=%.6g\n", row->n5_bytes,
+                    f->name, cascade_pass_rate(f));
+        }
+    }
+    fprintf(out, "cpu_hours=%.6g\n", e->cpu_hours);
+    fprintf(out, "cpu_hours_skipping=%.6g\n", e->cpu_hours_skipping);
+    fprintf(out, "wall_hours=%.6g\n", e->wall_hours);
+    fprintf(out, "setup_ns=%llu\n", (unsigned long long)e->setup_ns);
+    fprintf(out, "table_bytes=%zu\n", e->table_bytes);
+    fprintf(out, "mitm_table_bytes=%zu\n", e->mitm_table_bytes);
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "cascade.h"
+#include "fixed.h"
+#include "msd.h"
+#include "search.h"
+
+// Cascade filters over arrays of uBITS, arg points to the base. Base 3
+// gets its own loop so that its divisions compile to multiplications.
+#define FIXED_FILTER_LOOP(BITS, CHECK, BASE)                                  \
+    for (size_t i = 0; i < count; ++i) {                                      \
+        if (u##BITS##_##CHECK(&n[i], BASE)) {                                 \
+            n[kept++] = n[i];                                                 \
+        }                                                                     \
+    }
+
+#define FIXED_FILTERS_DEFINE(BITS)                                            \
+static size_t u##BITS##_filter_full(void *candidates, size_t count,           \
+                                    void const *arg) {                        \
+    u##BITS *n = candidates;                                                  \
+    int base = *(int const*)arg;                                              \
+    size_t kept = 0;                                                          \
+    if (base == 3) {                                                          \
+        FIXED_FILTER_LOOP(BITS, check_base, 3)                                \
+    } else {                                                                  \
+        FIXED_FILTER_LOOP(BITS, check_base, base)                             \
+    }                                                                         \
+    return kept;                                                              \
+}                                                                             \
+                                                                              \
+static size_t u##BITS##_filter_residue(void *candidates, size_t count,        \
+                                       void const *arg) {                     \
+    u##BITS *n = candidates;                                                  \
+    int base = *(int const*)arg;                                              \
+    size_t kept = 0;                                                          \
+    if (base == 3) {                                                          \
+        FIXED_FILTER_LOOP(BITS, check_residue, 3)                             \
+    } else {                                                                  \
+        FIXED_FILTER_LOOP(BITS, check_residue, base)                          \
+    }                                                                         \
+    return kept;                                                              \
+}                                                                             \
+                                                                              \
+static size_t u##BITS##_filter_msd(void *candidates, size_t count,            \
+                                   void const *arg) {                         \
+    u##BITS *n = candidates;                                                  \
+    size_t kept = 0;                                                          \
+    for (size_t i = 0; i < count; ++i) {                                      \
+        long double x = u##BITS##_to_ld(&n[i]);                               \
+        if (!msd_block_rejects(arg, x, x, MSD_ROUNDING_ERROR)) {              \
+            n[kept++] = n[i];                                                 \
+        }                                                                     \
+    }                                                                         \
+    return kept;                                                              \
+}
+
+// sums[i * 256 + j] is the value of an n5 whose byte i is j and every other
+// byte is zero, so n is the sum of one entry per byte of n5. Candidates go
+// through the filter cascade in batches that share all but the lowest byte
+// of n5, so the sum of the upper bytes is computed once per batch.
+// Where the low k bytes of n5 are all zero, the next 256**k patterns map to
+// n from high to high + tops[k]; if the leading digits of that whole block
+// are out it is skipped without looking at a single candidate.
+#define FIXED_SEARCH_DEFINE(BITS)                                             \
+static void search_u##BITS(bignum_base_ctx const *ctx, int base_cap,          \
+                           search_opts const *opts) {                         \
+    msd_table tables[SEARCH_MAX_BASE + 1];                                    \
+    search_msd_tables_init(tables, base_cap);                                 \
+    cascade filters;                                                          \
+    cascade_init(&filters, opts->cascade_period);                             \
+    search_add_filters(&filters, base_cap, u##BITS##_filter_residue,          \
+                       u##BITS##_filter_full, u##BITS##_filter_msd, tables);  \
+    cascade blocks;                                                           \
+    cascade_init(&blocks, opts->cascade_period);                              \
+    search_add_block_filters(&blocks, base_cap, tables);                      \
+    /* n5 stays below limit_bytes bytes, so its top byte is never read */     \
+    size_t rows = opts->limit_bytes - 1;                                      \
+    u##BITS *sums = malloc(rows * 256 * sizeof(u##BITS));                     \
+    u##BITS tops[SEARCH_MAX_LIMIT_BYTES];                                     \
+    u##BITS batch[256];                                                       \
+    bignum n5;                                                                \
+    bignum tmp;                                                               \
+    bignum_init(&n5);                                                         \
+    bignum_init(&tmp);                                                        \
+    for (int i = 0; i < rows; ++i) {                                          \
+        for (int j = 0; j < 256; ++j) {                                       \
+            memset(n5.data, 0, i);                                            \
+            n5.data[i] = j;                                                   \
+            n5.size = i + 1;                                                  \
+            bignum_base_convert(ctx, &tmp, &n5);                              \
+            u##BITS##_from_bignum(&sums[i * 256 + j], &tmp);                  \
+        }                                                                     \
+    }                                                                         \
+    u##BITS##_zero(&tops[0]);                                                 \
+    for (int k = 1; k < opts->limit_bytes; ++k) {                             \
+        tops[k] = tops[k - 1];                                                \
+        u##BITS##_add(&tops[k], &sums[(k - 1) * 256 + 255]);                  \
+    }                                                                         \
+    /* bytes above the size must be zero for bignum_inc to carry into */      \
+    memset(n5.data, 0, opts->limit_bytes);                                    \
+    bignum_from_int(&n5, 1);                                                  \
+    int last_size = n5.size;                                                  \
+    while (n5.size < opts->limit_bytes) {                                     \
+        u##BITS high;                                                         \
+        u##BITS##_zero(&high);                                                \
+        for (int i = 1; i < n5.size; ++i) {                                   \
+            u##BITS##_add(&high, &sums[i * 256 + n5.data[i]]);                \
+        }                                                                     \
+        int aligned = 0;                                                      \
+        while (aligned + 1 < n5.size && n5.data[aligned] == 0) {              \
+            ++aligned;                                                        \
+        }                                                                     \
+        int skip = 0;                                                         \
+        for (int k = aligned; k > 0 && !skip; --k) {                          \
+            u##BITS top = high;                                               \
+            u##BITS##_add(&top, &tops[k]);                                    \
+            msd_block block = {                                               \
+                u##BITS##_to_ld(&high), u##BITS##_to_ld(&top),                \
+                MSD_ROUNDING_ERROR,                                           \
+            };                                                                \
+            if (!cascade_run(&blocks, &block, 1)) {                           \
+                skip = k;                                                     \
+            }                                                                 \
+        }                                                                     \
+        if (skip) {                                                           \
+            memset(n5.data, 255, skip);                                       \
+            bignum_inc(&n5);                                                  \
+            if (n5.size > last_size) {                                        \
+                bignum_base_convert(ctx, &tmp, &n5);                          \
+                search_emit_progress(opts->sink, &n5, &tmp);                  \
+                last_size = n5.size;                                          \
+            }                                                                 \
+            continue;                                                         \
+        }                                                                     \
+        size_t count = 0;                                                     \
+        for (int low = n5.data[0]; low < 256; ++low) {                        \
+            batch[count] = high;                                              \
+            u##BITS##_add(&batch[count], &sums[low]);                         \
+            ++count;                                                          \
+        }                                                                     \
+        size_t passed = cascade_run(&filters, batch, count);                  \
+        for (size_t i = 0; i < passed; ++i) {                                 \
+            u##BITS##_to_bignum(&tmp, &batch[i]);                             \
+            search_emit_hit(opts->sink, base_cap, &tmp);                      \
+        }                                                                     \
+        n5.data[0] = 255;                                                     \
+        bignum_inc(&n5);                                                      \
+        if (n5.size > last_size) {                                            \
+            bignum_base_convert(ctx, &tmp, &n5);                              \
+            search_emit_progress(opts->sink, &n5, &tmp);                      \
+            last_size = n5.size;                                              \
+        }                                                                     \
+    }                                                                         \
+    search_emit_stats(opts->sink, &blocks);                                   \
+    search_emit_stats(opts->sink, &filters);                                  \
+    search_msd_tables_free(tables, base_cap);                                 \
+    bignum_free(&n5);                                                         \
+    bignum_free(&tmp);                                                        \
+    free(sums);                                                               \
+}
+
+FIXED_FILTERS_DEFINE(128)
+FIXED_FILTERS_DEFINE(192)
+FIXED_FILTERS_DEFINE(256)
+
+FIXED_SEARCH_DEFINE(128)
+FIXED_SEARCH_DEFINE(192)
+FIXED_SEARCH_DEFINE(256)
+
+// Runs search_run() on the narrowest fixed width that holds 'bits' bits.
+// Returns false if even 256 bits are not enough.
+bool search_fixed(bignum_base_ctx const *ctx, size_t bits, int base_cap,
+                  search_opts const *opts) {
+    if (bits <= 128) {
+        search_u128(ctx, base_cap, opts);
+    } else if (bits <= 192) {
+        search_u192(ctx, base_cap, opts);
+    } else if (bits <= 256) {
+        search_u256(ctx, base_cap, opts);
+    } else {
+        return false;
+    }
+    return true;
+}
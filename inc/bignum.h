@@ -14,32 +14,65 @@ typedef struct _bignum {
     bool    negative;
 } bignum;
 
+typedef struct _bignum_base_ctx bignum_base_ctx;
+
+// Largest power of base that fits in 32 bits, and its exponent. Chunks of
+// that many digits are peeled off or pushed onto a number with a single
+// division or multiplication. Inline so that a constant base folds away.
+static inline uint32_t bignum_chunk_pow(uint32_t base, int *digits) {
+    uint64_t pow = base;
+    *digits = 1;
+    while (pow * base <= 0xffffffffu) {
+        pow *= base;
+        ++*digits;
+    }
+    return pow;
+}
+
 void bignum_init_cap(bignum *n, size_t cap);
 void bignum_init(bignum *n);
 void bignum_resize(bignum *n);
+bool bignum_reserve(bignum *n, size_t cap);
 void bignum_free(bignum *n);
-void bignum_copy(bignum *dest, bignum *src);
-bool bignum_is_zero(bignum *n);
+void bignum_copy(bignum *dest, bignum const *src);
+bool bignum_is_zero(bignum const *n);
 void bignum_dump(bignum *n);
 void bignum_bprint(bignum *n);
 int bignum_to_int(bignum *n);
 void bignum_print_int(bignum *n);
 void bignum_from_char(bignum *n, uint8_t s);
 void bignum_from_int(bignum *n, int s);
+void bignum_from_u64(bignum *n, uint64_t s);
+void bignum_from_limbs(bignum *n, uint64_t const *limbs, size_t nlimbs);
+size_t bignum_to_limbs(bignum const *n, uint64_t *limbs, size_t nlimbs);
 void bignum_inc(bignum *n);
 void bignum_add(bignum *a, bignum *b);
 void bignum_sub(bignum* a, bignum *b);
 void bignum_mul_int(bignum *a, unsigned int b);
+int bignum_cmp(bignum const *a, bignum const *b);
 bool bignum_lte(bignum *a, bignum *b);
 void bignum_div_mod(bignum *a, bignum *b, bignum *remainder);
 void bignum_div_mod_int(bignum *a, int b, int *remainder);
+uint32_t bignum_div_mod_u32(bignum *a, uint32_t d);
+uint64_t bignum_mod_u64(bignum const *a, uint64_t m);
 void init_div_mod_int_lut();
 void bignum_div(bignum *a, bignum *b);
 void bignum_mod(bignum *a, bignum *b);
-void bignum_init_base_convert(size_t n, int base);
-void bignum_free_base_convert_lut();
-void bignum_base_convert(bignum *n, bignum* s);
+bignum_base_ctx *bignum_base_ctx_try_new(int base, size_t max_len);
+bignum_base_ctx *bignum_base_ctx_new(int base, size_t max_len);
+void bignum_base_ctx_free(bignum_base_ctx *ctx);
+int bignum_base_ctx_base(bignum_base_ctx const *ctx);
+size_t bignum_base_ctx_size(bignum_base_ctx const *ctx);
+size_t bignum_base_ctx_bytes(bignum_base_ctx const *ctx);
+bignum const *bignum_base_ctx_power(bignum_base_ctx const *ctx, size_t i);
+void bignum_base_convert(bignum_base_ctx const *ctx, bignum *n, bignum* s);
+bool bignum_next_ge(bignum_base_ctx const *ctx, bignum *r, bignum const *x,
+                    bignum *work, bignum *digits);
 void bignum_from_string_binary(bignum *n, char const* s, size_t base);
+void bignum_mul_add_int(bignum *a, uint32_t mul, uint32_t add);
+bool bignum_from_string(bignum *n, char const *s, size_t len, size_t base);
+size_t bignum_from_string_batch(bignum *out, size_t max, char const *buf,
+                                size_t len, size_t base, size_t *end);
 char* limited_precision_base_conv(long int number, size_t base);
 
 #endif
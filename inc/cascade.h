@@ -0,0 +1,55 @@
+#ifndef CASCADE_H__
+#define CASCADE_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CASCADE_MAX_FILTERS 24
+#define CASCADE_DEFAULT_PERIOD (1 << 16)
+#define CASCADE_SAMPLE_MASK 15
+
+// A filter gets an array of count candidates, moves the ones that pass to
+// the front, keeping their order, and returns how many passed. All filters
+// in one cascade take the same candidate type, arg is the filter's own
+// parameter. Working on batches keeps the indirect call, the bookkeeping
+// and the clock reads off the per-candidate path.
+typedef size_t (*filter_fn)(void *candidates, size_t count, void const *arg);
+
+typedef struct _filter {
+    char const *name;
+    filter_fn fn;
+    void const *arg;
+    uint64_t calls;  // candidates that reached this filter
+    uint64_t passes; // of which passed
+    uint64_t timed;  // candidates in the batches that were timed
+    uint64_t ns;     // total time of the timed batches
+} filter;
+
+// Runs filters in order until no candidate is left. Every reorder_period
+// candidates the filters are sorted by expected cost per rejection,
+// cost / (1 - pass rate), which minimizes the expected cost per candidate
+// when the filters are independent. Which candidates survive does not
+// depend on the order.
+typedef struct _cascade {
+    filter filters[CASCADE_MAX_FILTERS];
+    int order[CASCADE_MAX_FILTERS];
+    int nfilters;
+    uint64_t candidates;
+    uint64_t batches;
+    uint64_t reorder_period;
+    uint64_t until_reorder;
+    uint64_t reorders;
+    uint64_t clock_ns; // cost of reading the clock, subtracted from samples
+} cascade;
+
+void cascade_init(cascade *c, uint64_t reorder_period);
+void cascade_add(cascade *c, char const *name, filter_fn fn, void const *arg);
+size_t cascade_run(cascade *c, void *candidates, size_t count);
+void cascade_reorder(cascade *c);
+double cascade_pass_rate(filter const *f);
+double cascade_cost_ns(filter const *f);
+void cascade_report(cascade const *c, FILE *out);
+
+#endif
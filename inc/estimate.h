@@ -0,0 +1,50 @@
+#ifndef ESTIMATE_H__
+#define ESTIMATE_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "cascade.h"
+#include "mitm.h"
+#include "search.h"
+
+#define ESTIMATE_DEFAULT_SAMPLES 4096
+
+typedef struct _estimate_opts {
+    size_t limit_bytes; // the range to plan, n5 shorter than this
+    int workers;        // shards run side by side, for the wall time
+    size_t samples;     // per n5 length
+    mitm_opts mitm;     // for the size of its table
+} estimate_opts;
+
+// What the samples of one n5 length cost
+typedef struct _estimate_row {
+    int n5_bytes;
+    size_t n_bits;      // of the largest n of this length
+    double candidates;
+    double skipped;     // fraction in blocks the leading digit test skips
+    double convert_ns;  // per candidate
+    double check_ns;    // per candidate, whole cascade
+    double block_tests; // aligned blocks the fixed width search tests
+    double block_ns;    // per block test
+    cascade filters;    // pass rates of the samples
+} estimate_row;
+
+typedef struct _estimate {
+    estimate_row rows[SEARCH_MAX_LIMIT_BYTES];
+    int nrows;
+    size_t width;              // bits of the fixed width search, 0 bignum
+    uint64_t setup_ns;         // building the tables, included below
+    double cpu_hours;          // every candidate converted and checked
+    double cpu_hours_skipping; // only the ones block skipping leaves
+    double wall_hours;         // the skipping candidates over the workers,
+                               // each worker building its own tables
+    size_t table_bytes;        // base tables, sums and leading digit tables
+    size_t mitm_table_bytes;
+} estimate;
+
+void estimate_opts_default(estimate_opts *opts);
+void estimate_run(estimate_opts const *opts, estimate *e);
+void estimate_print(estimate_opts const *opts, estimate const *e, FILE *out);
+
+#endif
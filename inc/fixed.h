@@ -0,0 +1,173 @@
+#ifndef FIXED_H__
+#define FIXED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bignum.h"
+
+// Fixed-width unsigned integers for the search fast path. FIXED_DEFINE
+// generates a type uBITS of LIMBS little-endian 64 bit limbs together with
+// fully unrolled add, compare, divide by a small constant and 0/1 digit
+// checks. Everything is static inline so that the base passed to
+// uBITS_check_base folds into multiply-by-reciprocal divisions.
+
+#define FIXED_UNROLL _Pragma("GCC unroll 4")
+
+static inline bool fixed_chunk_check(uint32_t r, uint32_t base, int digits) {
+    for (int i = 0; i < digits && r != 0; ++i) {
+        if (r % base > 1) {
+            return false;
+        }
+        r /= base;
+    }
+    return true;
+}
+
+#define FIXED_DEFINE(BITS, LIMBS)                                             \
+typedef struct _u##BITS {                                                     \
+    uint64_t l[LIMBS];                                                        \
+} u##BITS;                                                                    \
+                                                                              \
+static inline void u##BITS##_zero(u##BITS *x) {                               \
+    FIXED_UNROLL                                                              \
+    for (int i = 0; i < LIMBS; ++i) {                                         \
+        x->l[i] = 0;                                                          \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static inline bool u##BITS##_is_zero(u##BITS const *x) {                      \
+    uint64_t acc = 0;                                                         \
+    FIXED_UNROLL                                                              \
+    for (int i = 0; i < LIMBS; ++i) {                                         \
+        acc |= x->l[i];                                                       \
+    }                                                                         \
+    return acc == 0;                                                          \
+}                                                                             \
+                                                                              \
+/* a += b, returns the carry out of the top limb */                           \
+static inline bool u##BITS##_add(u##BITS *a, u##BITS const *b) {              \
+    unsigned __int128 carry = 0;                                              \
+    FIXED_UNROLL                                                              \
+    for (int i = 0; i < LIMBS; ++i) {                                         \
+        carry += (unsigned __int128)a->l[i] + b->l[i];                        \
+        a->l[i] = (uint64_t)carry;                                            \
+        carry >>= 64;                                                         \
+    }                                                                         \
+    return carry != 0;                                                        \
+}                                                                             \
+                                                                              \
+static inline int u##BITS##_cmp(u##BITS const *a, u##BITS const *b) {         \
+    FIXED_UNROLL                                                              \
+    for (int i = LIMBS - 1; i >= 0; --i) {                                    \
+        if (a->l[i] != b->l[i]) {                                             \
+            return a->l[i] < b->l[i] ? -1 : 1;                                \
+        }                                                                     \
+    }                                                                         \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+/* x /= d, returns x % d. Works on 32 bit halves so that every step is a  */  \
+/* 64 by 32 bit division, which is a multiply when d is a constant.       */  \
+static inline uint32_t u##BITS##_divmod_small(u##BITS *x, uint32_t d) {       \
+    uint64_t rem = 0;                                                         \
+    FIXED_UNROLL                                                              \
+    for (int i = LIMBS - 1; i >= 0; --i) {                                    \
+        uint64_t cur = (rem << 32) | (x->l[i] >> 32);                         \
+        uint64_t hi = cur / d;                                                \
+        rem = cur % d;                                                        \
+        cur = (rem << 32) | (x->l[i] & 0xffffffffu);                          \
+        x->l[i] = (hi << 32) | (cur / d);                                     \
+        rem = cur % d;                                                        \
+    }                                                                         \
+    return rem;                                                               \
+}                                                                             \
+                                                                              \
+/* x % m for m < 2**32, without computing the quotient                   */   \
+static inline uint32_t u##BITS##_mod_small(u##BITS const *x, uint32_t m) {    \
+    uint64_t r64 = (((uint64_t)1 << 63) % m) * 2 % m; /* 2**64 mod m */     \
+    uint64_t rem = 0;                                                         \
+    FIXED_UNROLL                                                              \
+    for (int i = LIMBS - 1; i >= 0; --i) {                                    \
+        rem = (rem * r64 + x->l[i] % m) % m;                                  \
+    }                                                                         \
+    return rem;                                                               \
+}                                                                             \
+                                                                              \
+/* The lowest digits of n, as many as fit in one 32 bit chunk, are 0/1    */  \
+static inline bool u##BITS##_check_residue(u##BITS const *n, uint32_t base) { \
+    int digits;                                                               \
+    uint32_t chunk = bignum_chunk_pow(base, &digits);                         \
+    return fixed_chunk_check(u##BITS##_mod_small(n, chunk), base, digits);    \
+}                                                                             \
+                                                                              \
+static inline bool u##BITS##_check_base(u##BITS const *n, uint32_t base) {    \
+    if (base == 2) {                                                          \
+        return true;                                                          \
+    }                                                                         \
+    if (base == 4) {                                                          \
+        uint64_t acc = 0;                                                     \
+        FIXED_UNROLL                                                          \
+        for (int i = 0; i < LIMBS; ++i) {                                     \
+            acc |= n->l[i] & 0xaaaaaaaaaaaaaaaaull;                           \
+        }                                                                     \
+        return acc == 0;                                                      \
+    }                                                                         \
+    int digits;                                                               \
+    uint32_t chunk = bignum_chunk_pow(base, &digits);                         \
+    u##BITS work = *n;                                                        \
+    while (!u##BITS##_is_zero(&work)) {                                       \
+        uint32_t r = u##BITS##_divmod_small(&work, chunk);                    \
+        if (!fixed_chunk_check(r, base, digits)) {                            \
+            return false;                                                     \
+        }                                                                     \
+    }                                                                         \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+/* Rounded from the top two non-zero limbs, at least 65 significant bits, */  \
+/* so within MSD_ROUNDING_ERROR                                           */  \
+static inline long double u##BITS##_to_ld(u##BITS const *x) {                 \
+    int top = LIMBS - 1;                                                      \
+    while (top > 0 && x->l[top] == 0) {                                       \
+        --top;                                                                \
+    }                                                                         \
+    long double r = x->l[top];                                                \
+    if (top > 0) {                                                            \
+        r = r * 18446744073709551616.0L + x->l[top - 1];                      \
+        for (int i = 1; i < top; ++i) {                                       \
+            r *= 18446744073709551616.0L;                                     \
+        }                                                                     \
+    }                                                                         \
+    return r;                                                                 \
+}                                                                             \
+                                                                              \
+static inline void u##BITS##_from_bignum(u##BITS *x, bignum const *n) {       \
+    assert(n->size <= LIMBS * 8);                                             \
+    u##BITS##_zero(x);                                                        \
+    for (size_t i = 0; i < n->size; ++i) {                                    \
+        x->l[i / 8] |= (uint64_t)n->data[i] << (8 * (i % 8));                 \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static inline void u##BITS##_to_bignum(bignum *n, u##BITS const *x) {         \
+    while (n->cap < LIMBS * 8) {                                              \
+        bignum_resize(n);                                                     \
+    }                                                                         \
+    for (size_t i = 0; i < LIMBS * 8; ++i) {                                  \
+        n->data[i] = x->l[i / 8] >> (8 * (i % 8));                            \
+    }                                                                         \
+    n->size = LIMBS * 8;                                                      \
+    n->negative = false;                                                      \
+    while (n->size > 0 && n->data[n->size - 1] == 0) {                        \
+        --n->size;                                                            \
+    }                                                                         \
+}
+
+FIXED_DEFINE(128, 2)
+FIXED_DEFINE(192, 3)
+FIXED_DEFINE(256, 4)
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef LEAPFROG_H__
+#define LEAPFROG_H__
+
+#include <stdint.h>
+
+#include "search.h"
+
+typedef struct _leapfrog_stats {
+    uint64_t jumps; // next_ge calls that moved x forward
+    uint64_t hits;
+} leapfrog_stats;
+
+void search_leapfrog(search_opts const *opts, leapfrog_stats *stats);
+void bench_leapfrog();
+
+#endif
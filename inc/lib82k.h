@@ -0,0 +1,74 @@
+#ifndef LIB82K_H__
+#define LIB82K_H__
+
+// lib82k: batch checks and range searches without the 82k executable.
+// Every call is reentrant, writes its results into caller buffers and
+// prints nothing. Bad arguments and failed allocations come back as
+// return codes, the process is never exited.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define K82_API_VERSION 1
+
+#if defined(__GNUC__)
+#define K82_API __attribute__((visibility("default")))
+#else
+#define K82_API
+#endif
+
+// Return codes
+#define K82_OK      0
+#define K82_EINVAL -1 // bad arguments or a string that is not a number
+#define K82_ENOMEM -2 // out[i] of the items that couldn't be checked is 0
+
+// A set of bases, bit b stands for base b, bases 2 to K82_MAX_BASE
+typedef uint32_t k82_bases;
+#define K82_MAX_BASE 10
+#define K82_BASE(b) ((k82_bases)1 << (b))
+// bases 2 to cap
+#define K82_BASES_TO(cap) (((k82_bases)2 << (cap)) - 4)
+
+// Threads a call may use, 0 picks the number of online cpus
+typedef struct _k82_opts {
+    int threads;
+} k82_opts;
+
+K82_API int k82_api_version(void);
+
+// out[i] = 1 if number i has only 0/1 digits in every base of the set,
+// else 0. Number i is limbs[i * nlimbs] to limbs[i * nlimbs + nlimbs - 1],
+// 64 bits each, least significant first.
+K82_API int k82_check_limbs(uint64_t const *limbs, size_t nlimbs,
+                            size_t count, k82_bases bases,
+                            k82_opts const *opts, uint8_t *out);
+
+// Same with count NUL terminated strings in radix 2 to 36. Any string that
+// is not a number gets out[i] = 0 and makes the call return K82_EINVAL.
+K82_API int k82_check_strings(char const *const *strs, size_t count,
+                              int radix, k82_bases bases,
+                              k82_opts const *opts, uint8_t *out);
+
+// A pattern p stands for the number whose digits in pattern_base are the
+// bits of p, so every such number trivially passes pattern_base.
+// k82_search_range tests the patterns first <= p < last against the set and
+// writes the passing ones in increasing order to hits. *nhits gets their
+// total count; only the first max_hits of them are written.
+K82_API int k82_search_range(int pattern_base, uint64_t first, uint64_t last,
+                             k82_bases bases, k82_opts const *opts,
+                             uint64_t *hits, size_t max_hits, size_t *nhits);
+
+// The number of a pattern as nlimbs limbs, least significant first. *used
+// gets the limbs it takes; K82_EINVAL if that is more than nlimbs.
+K82_API int k82_pattern_value(int pattern_base, uint64_t pattern,
+                              uint64_t *limbs, size_t nlimbs, size_t *used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
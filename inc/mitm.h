@@ -0,0 +1,22 @@
+#ifndef MITM_H__
+#define MITM_H__
+
+#include <stddef.h>
+
+#include "search.h"
+
+typedef struct _mitm_opts {
+    int bits;    // n5 patterns below 2**bits are searched
+    int split;   // low half L takes this many bits, 2**split table entries
+    int workers; // threads for the build and probe phases
+    int depth;   // base 3 digits of the residue sieve, 0 for the deepest
+                 // that keeps 3**depth within 2**split
+    search_sink const *sink;
+} mitm_opts;
+
+void mitm_opts_default(mitm_opts *opts);
+int mitm_sieve_depth(mitm_opts const *opts);
+size_t mitm_table_bytes(mitm_opts const *opts);
+void search_mitm(mitm_opts const *opts);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MSD_H__
+#define MSD_H__
+
+#include <float.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bignum.h"
+
+// The error bounds assume every power below 2**64 is exact and every
+// number keeps its top 64 bits, as in the x87 extended format. Where long
+// double is narrower every test answers "unsure" and the filters pass
+// everything to the exact checks.
+#define MSD_EXACT (LDBL_MANT_DIG >= 64)
+
+// Leading digit estimates in long double. Where the rounding errors could
+// change a leading digit the answer is "unsure" and the caller falls back
+// to an exact check, so a rejection here is always exact.
+typedef struct _msd_table {
+    int base;
+    int digits;         // leading digits looked at, base**digits < 2**32
+    int npowers;
+    long double *pow;   // base**i rounded, i < npowers
+    long double *error; // relative error bound of pow[i]
+} msd_table;
+
+// All numbers from lo to hi, both rounded within a relative error
+typedef struct _msd_block {
+    long double lo;
+    long double hi;
+    long double error;
+} msd_block;
+
+// Relative error of a number rounded from its top 64 bits
+#define MSD_ROUNDING_ERROR (1.0L / 4611686018427387904.0L) // 2**-62
+
+void msd_table_init(msd_table *t, int base, int npowers);
+void msd_table_free(msd_table *t);
+bool msd_block_rejects(msd_table const *t, long double lo, long double hi,
+                       long double error);
+long double msd_from_bignum(bignum const *n);
+size_t msd_filter_block(void *candidates, size_t count, void const *arg);
+
+#endif
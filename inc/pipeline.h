@@ -0,0 +1,23 @@
+#ifndef PIPELINE_H__
+#define PIPELINE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "search.h"
+
+#define PIPELINE_DEFAULT_DEPTH 4096
+#define PIPELINE_DEFAULT_BATCH 64
+
+typedef struct _pipeline_opts {
+    size_t depth; // records per ring between two stages
+    size_t batch; // records moved per push/pop
+    bool   pin;   // pin each stage to its own core
+    size_t limit_bytes; // walk n5 while it is shorter than this
+    search_sink const *sink;
+} pipeline_opts;
+
+void pipeline_opts_default(pipeline_opts *opts);
+void search_pipelined(pipeline_opts const *opts);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef RING_H__
+#define RING_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CACHE_LINE 64
+
+// Single-producer/single-consumer lock-free ring buffer of fixed-size
+// records. Exactly one thread may push and exactly one thread may pop.
+typedef struct _ring {
+    size_t head; // next slot to write, owned by the producer
+    char   pad0[CACHE_LINE - sizeof(size_t)];
+    size_t tail; // next slot to read, owned by the consumer
+    char   pad1[CACHE_LINE - sizeof(size_t)];
+    size_t mask;
+    size_t elem_size;
+    unsigned char *slots;
+} ring;
+
+bool ring_init(ring *r, size_t depth, size_t elem_size);
+void ring_free(ring *r);
+size_t ring_push(ring *r, void const *elems, size_t count);
+size_t ring_pop(ring *r, void *elems, size_t max);
+void ring_push_all(ring *r, void const *elems, size_t count);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SEARCH_H__
+#define SEARCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bignum.h"
+#include "cascade.h"
+#include "msd.h"
+
+// search_run() walks n5 by default while it is shorter than this many bytes
+#ifndef SEARCH_LIMIT_BYTES
+#define SEARCH_LIMIT_BYTES 4
+#endif
+// bignum_base_convert takes n5 of at most 8 bytes
+#define SEARCH_MAX_LIMIT_BYTES 8
+// the filters cover bases up to this
+#define SEARCH_MAX_BASE 10
+// residue, leading digit and full check for each base from 3 up
+#if 3 * (SEARCH_MAX_BASE - 2) > CASCADE_MAX_FILTERS
+#error "CASCADE_MAX_FILTERS can't hold the filters of SEARCH_MAX_BASE"
+#endif
+// leading digit tables reach base**SEARCH_MSD_POWERS, past any n we search
+#define SEARCH_MSD_POWERS (40*8)
+
+// Where the search engines report to. Any callback may be NULL.
+typedef struct _search_sink {
+    // n has only 0/1 digits in every base from 2 to base_cap + 1
+    void (*hit)(void *user, int base_cap, bignum *n);
+    // n5 just grew by a byte, n is its value
+    void (*progress)(void *user, bignum *n5, bignum *n);
+    // every filter cascade at the end of a search
+    void (*stats)(void *user, cascade const *c);
+    void *user;
+} search_sink;
+
+// The original output: hits and progress on stdout, stats on stderr
+extern search_sink const search_sink_stdout;
+// Reports nothing, for benchmarks and tuning runs
+extern search_sink const search_sink_quiet;
+
+typedef struct _search_opts {
+    size_t limit_bytes; // walk n5 while it is shorter than this
+    uint64_t cascade_period;
+    search_sink const *sink;
+} search_opts;
+
+char* unlimited_precision_base_conv(bignum *number, size_t base);
+bool check_base_with(bignum *n, int base, bignum *work);
+bool check_base(bignum *n, int base);
+bool check_residue(bignum *n, int base);
+void search_msd_tables_init(msd_table *tables, int base_cap);
+void search_msd_tables_free(msd_table *tables, int base_cap);
+void search_add_filters(cascade *c, int base_cap, filter_fn residue,
+                        filter_fn full, filter_fn msd,
+                        msd_table const *tables);
+void search_add_bignum_filters(cascade *c, int base_cap,
+                               msd_table const *tables);
+void search_add_block_filters(cascade *c, int base_cap,
+                              msd_table const *tables);
+void search_emit_hit(search_sink const *sink, int base_cap, bignum *n);
+void search_emit_progress(search_sink const *sink, bignum *n5, bignum *n);
+void search_emit_stats(search_sink const *sink, cascade const *c);
+void search_bignum(bignum_base_ctx const *ctx, int base_cap,
+                   search_opts const *opts);
+bool search_fixed(bignum_base_ctx const *ctx, size_t bits, int base_cap,
+                  search_opts const *opts);
+void search_opts_default(search_opts *opts);
+void search_run(search_opts const *opts);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef TIMING_H__
+#define TIMING_H__
+
+#include <stdint.h>
+#include <time.h>
+
+// Monotonic clock in ns, for every timing in the benchmarks and the tuner
+static inline uint64_t timing_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TUNE_H__
+#define TUNE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mitm.h"
+#include "pipeline.h"
+#include "search.h"
+
+// Per-host choice of tunables, saved by --autotune and loaded on startup
+typedef struct _tune_profile {
+    size_t pipeline_depth;
+    size_t pipeline_batch;
+    int mitm_split_bias; // split = bits / 2 + bias
+    int mitm_workers;
+    int mitm_depth;      // residue sieve depth, 0 for the deepest
+} tune_profile;
+
+void tune_profile_default(tune_profile *p);
+void tune_profile_path(char *buf, size_t len);
+bool tune_profile_load(tune_profile *p, char const *path);
+bool tune_profile_save(tune_profile const *p, char const *path);
+void tune_pipeline_opts(tune_profile const *p, pipeline_opts *opts);
+void tune_mitm_opts(tune_profile const *p, mitm_opts *opts);
+void autotune(tune_profile *p, FILE *out);
+
+#endif
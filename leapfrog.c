@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <assert.h>
+
+#include "bignum.h"
+#include "search.h"
+#include "timing.h"
+#include "leapfrog.h"
+
+// search_run() reports a progress line whenever n5 grows to k + 1 bytes,
+// that is where n reaches 5**(8*k). Reports those that x has reached.
+static void emit_progress(search_opts const *opts,
+                          bignum_base_ctx const *ctx5, bignum const *x,
+                          size_t *grown) {
+    for (; *grown < opts->limit_bytes; ++*grown) {
+        bignum const *power = bignum_base_ctx_power(ctx5, 8 * *grown);
+        if (bignum_cmp(x, power) < 0) {
+            break;
+        }
+        bignum n5;
+        bignum n;
+        bignum_init(&n5);
+        bignum_init(&n);
+        bignum_from_u64(&n5, (uint64_t)1 << (8 * *grown));
+        bignum_copy(&n, power);
+        search_emit_progress(opts->sink, &n5, &n);
+        bignum_free(&n5);
+        bignum_free(&n);
+    }
+}
+
+// Instead of walking every base 5 pattern, x leapfrogs: each base in turn
+// moves x up to the next number with only 0/1 digits in that base, until
+// no base moves it any more. Whole ranges that fail in base 4 or base 3
+// are skipped with a single jump. Covers the same range as search_run()
+// and reports the same hits and progress lines, in the same order.
+void search_leapfrog(search_opts const *opts, leapfrog_stats *stats) {
+    assert(opts->limit_bytes >= 2 && opts->limit_bytes <= SEARCH_MAX_LIMIT_BYTES);
+    int base_cap = 4;
+    bignum_base_ctx *ctx[5] = {NULL};
+    for (int base = 3; base <= base_cap + 1; ++base) {
+        ctx[base - 3] = bignum_base_ctx_new(base, 40*8);
+    }
+    bignum_base_ctx *ctx5 = ctx[base_cap + 1 - 3];
+    bignum const *bound = bignum_base_ctx_power(ctx5,
+                                                8 * (opts->limit_bytes - 1));
+    bignum x;
+    bignum next;
+    bignum work;
+    bignum digits;
+    bignum_init(&x);
+    bignum_init(&next);
+    bignum_init(&work);
+    bignum_init(&digits);
+    bignum_from_int(&x, 1);
+    size_t grown = 1;
+    stats->jumps = 0;
+    stats->hits = 0;
+    while (true) {
+        bool moved = true;
+        while (moved && bignum_cmp(&x, bound) < 0) {
+            moved = false;
+            for (int base = base_cap + 1; base > 2; --base) {
+                // x stays below 5**56, far inside every table
+                bool ok = bignum_next_ge(ctx[base - 3], &next, &x, &work,
+                                         &digits);
+                assert(ok);
+                if (bignum_cmp(&next, &x) != 0) {
+                    bignum t = x;
+                    x = next;
+                    next = t;
+                    ++stats->jumps;
+                    moved = true;
+                }
+            }
+        }
+        emit_progress(opts, ctx5, &x, &grown);
+        if (bignum_cmp(&x, bound) >= 0) {
+            break;
+        }
+        search_emit_hit(opts->sink, base_cap, &x);
+        ++stats->hits;
+        bignum_inc(&x);
+    }
+    bignum_free(&x);
+    bignum_free(&next);
+    bignum_free(&work);
+    bignum_free(&digits);
+    for (int base = 3; base <= base_cap + 1; ++base) {
+        bignum_base_ctx_free(ctx[base - 3]);
+    }
+}
+
+// Times search_run() and search_leapfrog() over the same range, both
+// reporting to a quiet sink so that only the timings are printed
+void bench_leapfrog() {
+    search_opts opts;
+    search_opts_default(&opts);
+    opts.sink = &search_sink_quiet;
+    leapfrog_stats stats;
+    uint64_t start = timing_now_ns();
+    search_run(&opts);
+    double walk = (timing_now_ns() - start) / 1e9;
+    start = timing_now_ns();
+    search_leapfrog(&opts, &stats);
+    double leap = (timing_now_ns() - start) / 1e9;
+    fprintf(stderr, "search: %.3fs, leapfrog: %.3fs (%llu jumps, %llu hits)\n",
+            walk, leap, (unsigned long long)stats.jumps,
+            (unsigned long long)stats.hits);
+}
@@ -0,0 +1,342 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "bignum.h"
+#include "lib82k.h"
+#include "search.h"
+
+#define K82_ALL_BASES K82_BASES_TO(K82_MAX_BASE)
+
+typedef struct _k82_call {
+    k82_bases bases;
+    // k82_check_limbs
+    uint64_t const *limbs;
+    size_t nlimbs;
+    // k82_check_strings
+    char const *const *strs;
+    int radix;
+    // k82_search_range
+    bignum_base_ctx const *ctx;
+    uint64_t first;
+    uint8_t *out;
+} k82_call;
+
+typedef struct _k82_worker {
+    pthread_t thread;
+    k82_call const *call;
+    uint64_t from, to; // items or pattern offsets
+    int status;
+    uint64_t *hits;
+    size_t nhits, hits_cap;
+} k82_worker;
+
+int k82_api_version(void) {
+    return K82_API_VERSION;
+}
+
+static bool valid_bases(k82_bases bases) {
+    return (bases & ~K82_ALL_BASES) == 0;
+}
+
+// Residue tests of every base first, they are cheaper than full checks.
+// work is scratch of at least n->size bytes.
+static bool check_bases(bignum *n, bignum *work, k82_bases bases) {
+    for (int base = 3; base <= K82_MAX_BASE; ++base) {
+        if ((bases & K82_BASE(base)) && (base & (base - 1))
+                && !check_residue(n, base)) {
+            return false;
+        }
+    }
+    for (int base = 3; base <= K82_MAX_BASE; ++base) {
+        if ((bases & K82_BASE(base)) && !check_base_with(n, base, work)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int nthreads(k82_opts const *opts, uint64_t count) {
+    long threads = opts ? opts->threads : 1;
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    return count < (uint64_t)threads ? (count > 0 ? count : 1) : threads;
+}
+
+// The worst status of a worker wins, K82_ENOMEM over K82_EINVAL
+static void worker_fail(k82_worker *w, int status) {
+    if (status < w->status) {
+        w->status = status;
+    }
+}
+
+// A number of the worker and the scratch check_bases needs, false with
+// K82_ENOMEM if either can't be allocated
+static bool worker_bignums(k82_worker *w, bignum *n, bignum *work) {
+    bignum_init(n);
+    bignum_init(work);
+    if (!n->data || !work->data) {
+        bignum_free(n);
+        bignum_free(work);
+        worker_fail(w, K82_ENOMEM);
+        return false;
+    }
+    return true;
+}
+
+// Both grown to cap bytes so that nothing reallocates during the item
+static bool worker_reserve(k82_worker *w, bignum *n, bignum *work,
+                           size_t cap) {
+    if (!bignum_reserve(n, cap) || !bignum_reserve(work, cap)) {
+        worker_fail(w, K82_ENOMEM);
+        return false;
+    }
+    return true;
+}
+
+// Splits [0, count) over nworkers threads, the last range runs on the
+// calling thread and so does any range whose thread can't be started
+static int k82_run(k82_call const *call, uint64_t count, int nworkers,
+                   void *(*fn)(void*), k82_worker **out) {
+    *out = NULL;
+    // main() of the 82k executable does this, a host program doesn't
+    init_div_mod_int_lut();
+    k82_worker *workers = calloc(nworkers, sizeof(k82_worker));
+    if (!workers) {
+        return K82_ENOMEM;
+    }
+    uint64_t step = count / nworkers + (count % nworkers != 0);
+    bool *started = calloc(nworkers, sizeof(bool));
+    if (!started) {
+        free(workers);
+        return K82_ENOMEM;
+    }
+    for (int i = 0; i < nworkers; ++i) {
+        workers[i].call = call;
+        workers[i].from = i * step < count ? i * step : count;
+        workers[i].to = (i + 1) * step < count ? (i + 1) * step : count;
+        if (i + 1 < nworkers) {
+            started[i] = 0 == pthread_create(&workers[i].thread, NULL, fn,
+                                             &workers[i]);
+        }
+    }
+    for (int i = 0; i < nworkers; ++i) {
+        if (!started[i]) {
+            fn(&workers[i]);
+        }
+    }
+    int status = K82_OK;
+    for (int i = 0; i < nworkers; ++i) {
+        if (started[i]) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        if (workers[i].status < status) {
+            status = workers[i].status;
+        }
+    }
+    free(started);
+    *out = workers;
+    return status;
+}
+
+static void k82_free_workers(k82_worker *workers, int nworkers) {
+    if (!workers) {
+        return;
+    }
+    for (int i = 0; i < nworkers; ++i) {
+        free(workers[i].hits);
+    }
+    free(workers);
+}
+
+static void *check_limbs_worker(void *arg) {
+    k82_worker *w = arg;
+    k82_call const *c = w->call;
+    bignum n;
+    bignum work;
+    if (!worker_bignums(w, &n, &work)) {
+        memset(&c->out[w->from], 0, w->to - w->from);
+        return NULL;
+    }
+    if (!worker_reserve(w, &n, &work, c->nlimbs * 8)) {
+        memset(&c->out[w->from], 0, w->to - w->from);
+        w->to = w->from;
+    }
+    for (uint64_t i = w->from; i < w->to; ++i) {
+        bignum_from_limbs(&n, &c->limbs[i * c->nlimbs], c->nlimbs);
+        c->out[i] = check_bases(&n, &work, c->bases);
+    }
+    bignum_free(&n);
+    bignum_free(&work);
+    return NULL;
+}
+
+int k82_check_limbs(uint64_t const *limbs, size_t nlimbs, size_t count,
+                    k82_bases bases, k82_opts const *opts, uint8_t *out) {
+    if (!valid_bases(bases) || (count > 0 && (!limbs || !out))) {
+        return K82_EINVAL;
+    }
+    k82_call call = {
+        .bases = bases, .limbs = limbs, .nlimbs = nlimbs, .out = out,
+    };
+    int nworkers = nthreads(opts, count);
+    k82_worker *workers;
+    int status = k82_run(&call, count, nworkers, check_limbs_worker,
+                         &workers);
+    k82_free_workers(workers, nworkers);
+    return status;
+}
+
+static void *check_strings_worker(void *arg) {
+    k82_worker *w = arg;
+    k82_call const *c = w->call;
+    bignum n;
+    bignum work;
+    if (!worker_bignums(w, &n, &work)) {
+        memset(&c->out[w->from], 0, w->to - w->from);
+        return NULL;
+    }
+    for (uint64_t i = w->from; i < w->to; ++i) {
+        char const *s = c->strs[i];
+        c->out[i] = 0;
+        // an empty string would parse as 0
+        if (!s || !*s) {
+            worker_fail(w, K82_EINVAL);
+            continue;
+        }
+        // a digit of radix 36 and below takes less than 6 bits
+        size_t len = strlen(s);
+        if (!worker_reserve(w, &n, &work, len * 6 / 8 + 8)) {
+            continue;
+        }
+        if (!bignum_from_string(&n, s, len, c->radix)) {
+            worker_fail(w, K82_EINVAL);
+            continue;
+        }
+        c->out[i] = check_bases(&n, &work, c->bases);
+    }
+    bignum_free(&n);
+    bignum_free(&work);
+    return NULL;
+}
+
+int k82_check_strings(char const *const *strs, size_t count, int radix,
+                      k82_bases bases, k82_opts const *opts, uint8_t *out) {
+    if (!valid_bases(bases) || radix < 2 || radix > 36
+            || (count > 0 && (!strs || !out))) {
+        return K82_EINVAL;
+    }
+    k82_call call = {
+        .bases = bases, .strs = strs, .radix = radix, .out = out,
+    };
+    int nworkers = nthreads(opts, count);
+    k82_worker *workers;
+    int status = k82_run(&call, count, nworkers, check_strings_worker,
+                         &workers);
+    k82_free_workers(workers, nworkers);
+    return status;
+}
+
+// Patterns are at most 64 digits of a base up to 10, below 2**213, so the
+// default capacity holds every n without growing
+static void *search_range_worker(void *arg) {
+    k82_worker *w = arg;
+    k82_call const *c = w->call;
+    bignum n5;
+    bignum n;
+    bignum work;
+    if (!worker_bignums(w, &n, &work)) {
+        return NULL;
+    }
+    bignum_init(&n5);
+    if (!n5.data) {
+        worker_fail(w, K82_ENOMEM);
+        w->to = w->from;
+    }
+    for (uint64_t i = w->from; i < w->to; ++i) {
+        uint64_t pattern = c->first + i;
+        bignum_from_u64(&n5, pattern);
+        bignum_base_convert(c->ctx, &n, &n5);
+        if (!check_bases(&n, &work, c->bases)) {
+            continue;
+        }
+        if (w->nhits == w->hits_cap) {
+            size_t cap = w->hits_cap ? 2 * w->hits_cap : 64;
+            uint64_t *hits = realloc(w->hits, cap * sizeof(uint64_t));
+            if (!hits) {
+                worker_fail(w, K82_ENOMEM);
+                break;
+            }
+            w->hits = hits;
+            w->hits_cap = cap;
+        }
+        w->hits[w->nhits++] = pattern;
+    }
+    bignum_free(&n5);
+    bignum_free(&n);
+    bignum_free(&work);
+    return NULL;
+}
+
+int k82_search_range(int pattern_base, uint64_t first, uint64_t last,
+                     k82_bases bases, k82_opts const *opts,
+                     uint64_t *hits, size_t max_hits, size_t *nhits) {
+    if (pattern_base < 2 || pattern_base > K82_MAX_BASE
+            || !valid_bases(bases) || first > last || !nhits
+            || (max_hits > 0 && !hits)) {
+        return K82_EINVAL;
+    }
+    *nhits = 0;
+    // every pattern is at most 8 bytes, so 64 powers of pattern_base
+    bignum_base_ctx *ctx = bignum_base_ctx_try_new(pattern_base, 64);
+    if (!ctx) {
+        return K82_ENOMEM;
+    }
+    k82_call call = {
+        .bases = bases & ~K82_BASE(pattern_base), .ctx = ctx, .first = first,
+    };
+    int nworkers = nthreads(opts, last - first);
+    k82_worker *workers;
+    int status = k82_run(&call, last - first, nworkers, search_range_worker,
+                         &workers);
+    if (workers) {
+        // the workers cover consecutive ranges, so their hits are in order
+        for (int i = 0; i < nworkers; ++i) {
+            for (size_t j = 0; j < workers[i].nhits; ++j) {
+                if (*nhits < max_hits) {
+                    hits[*nhits] = workers[i].hits[j];
+                }
+                ++*nhits;
+            }
+        }
+        k82_free_workers(workers, nworkers);
+    }
+    bignum_base_ctx_free(ctx);
+    return status;
+}
+
+int k82_pattern_value(int pattern_base, uint64_t pattern, uint64_t *limbs,
+                      size_t nlimbs, size_t *used) {
+    if (pattern_base < 2 || pattern_base > K82_MAX_BASE || !used
+            || (nlimbs > 0 && !limbs)) {
+        return K82_EINVAL;
+    }
+    // 64 digits of a base up to 10 fit the default capacity
+    bignum n;
+    bignum_init(&n);
+    if (!n.data) {
+        return K82_ENOMEM;
+    }
+    bignum_from_int(&n, 0);
+    for (int bit = 63; bit >= 0; --bit) {
+        bignum_mul_add_int(&n, pattern_base, (pattern >> bit) & 1);
+    }
+    *used = bignum_to_limbs(&n, limbs, nlimbs);
+    bignum_free(&n);
+    return *used > nlimbs ? K82_EINVAL : K82_OK;
+}
@@ -0,0 +1,27 @@
+// A host program of lib82k: only the public header and the archive, no
+// 82k main() to set anything up first. Built and run by make lib-t.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "lib82k.h"
+
+int main() {
+    // the first call of the process goes through the division tables
+    uint64_t limbs[] = {82000, 84, 1};
+    uint8_t out[3];
+    assert(k82_check_limbs(limbs, 1, 3, K82_BASES_TO(5), NULL, out) == K82_OK);
+    assert(out[0] == 1 && out[1] == 0 && out[2] == 1);
+    char const *strs[] = {"82000", "84"};
+    assert(k82_check_strings(strs, 2, 10, K82_BASES_TO(5), NULL, out)
+           == K82_OK);
+    assert(out[0] == 1 && out[1] == 0);
+    k82_opts opts = { 2 };
+    uint64_t hits[4];
+    size_t nhits;
+    assert(k82_search_range(5, 1, 1 << 16, K82_BASES_TO(4), &opts, hits, 4,
+                            &nhits) == K82_OK);
+    assert(nhits == 2 && hits[0] == 1 && hits[1] == 184);
+    printf("lib82k OK\n");
+    return 0;
+}
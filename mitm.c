@@ -0,0 +1,282 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "bignum.h"
+#include "search.h"
+#include "mitm.h"
+
+// Meet-in-the-middle over base 5 0/1 patterns. A pattern p = H<<split | L
+// stands for n = H*5**split + L5, where L5 is L read in base 5. For n to
+// have only 0/1 digits in base 3 its lowest k3 base 3 digits must already
+// be 0/1, so n mod 3**k3 must be one of 2**k3 valid residues. The table
+// buckets every low half by L5 mod 3**k3, so each high half only visits
+// the low halves that can possibly match, and those are further filtered
+// by their base 4 residue before the full check.
+
+#define MITM_MAX_BITS 64
+#define MITM_MAX_SPLIT 30
+
+typedef struct _mitm_entry {
+    uint32_t low;  // L
+    uint32_t res4; // L5 mod 4**k4
+} mitm_entry;
+
+typedef struct _mitm_table {
+    bignum_base_ctx *ctx;
+    int split;
+    uint64_t mod3, mod4;
+    uint64_t p3[MITM_MAX_BITS]; // 5**i mod 3**k3
+    uint64_t p4[MITM_MAX_BITS]; // 5**i mod 4**k4
+    uint32_t *res3;             // L5 mod 3**k3 for every L, build scratch
+    uint32_t *res4;             // L5 mod 4**k4 for every L, build scratch
+    uint32_t *bucket;           // mod3 + 1 offsets into entries
+    mitm_entry *entries;        // 2**split entries, sorted by res3
+    uint32_t *valid3;           // 2**k3 residues with only 0/1 digits
+    size_t nvalid3;
+} mitm_table;
+
+typedef struct _mitm_worker {
+    pthread_t thread;
+    mitm_table *t;
+    uint64_t from, to; // L range when building, H range when probing
+    uint64_t *hits;
+    size_t nhits, hits_cap;
+} mitm_worker;
+
+void mitm_opts_default(mitm_opts *opts) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    opts->bits = 8 * (SEARCH_LIMIT_BYTES - 1);
+    opts->split = opts->bits / 2;
+    opts->workers = ncpu > 0 ? ncpu : 1;
+    opts->depth = 0;
+    opts->sink = &search_sink_stdout;
+}
+
+static uint64_t ipow(uint64_t base, int k) {
+    uint64_t r = 1;
+    while (k-- > 0) {
+        r *= base;
+    }
+    return r;
+}
+
+static int residue_digits(int base, int split) {
+    // as many digits as fit in 32 bits, fewer if base**k would outgrow
+    // the 2**split low halves
+    int k;
+    bignum_chunk_pow(base, &k);
+    while (k > 1 && split < 32 && ipow(base, k) > (uint64_t)1 << split) {
+        --k;
+    }
+    return k;
+}
+
+// A deeper sieve visits fewer low halves per valid residue, but there are
+// 2**depth residues to visit for every high half. Depths past the deepest
+// one are clamped to it.
+int mitm_sieve_depth(mitm_opts const *opts) {
+    int deepest = residue_digits(3, opts->split);
+    return opts->depth > 0 && opts->depth < deepest ? opts->depth : deepest;
+}
+
+size_t mitm_table_bytes(mitm_opts const *opts) {
+    size_t nlow = (size_t)1 << opts->split;
+    size_t mod3 = ipow(3, mitm_sieve_depth(opts));
+    size_t nvalid3 = (size_t)1 << mitm_sieve_depth(opts);
+    return nlow * (sizeof(mitm_entry) + 2 * sizeof(uint32_t))
+        + (mod3 + 1) * sizeof(uint32_t)
+        + nvalid3 * sizeof(uint32_t);
+}
+
+static bool only_01_digits(uint64_t x, int base) {
+    while (x > 0) {
+        if (x % base > 1) {
+            return false;
+        }
+        x /= base;
+    }
+    return true;
+}
+
+static uint64_t pattern_residue(uint64_t const *p, uint64_t bits,
+                                int shift, uint64_t mod) {
+    uint64_t r = 0;
+    for (int i = 0; bits != 0; ++i, bits >>= 1) {
+        if (bits & 1) {
+            r += p[shift + i];
+        }
+    }
+    return r % mod;
+}
+
+static void *mitm_build_worker(void *arg) {
+    mitm_worker *w = arg;
+    mitm_table *t = w->t;
+    for (uint64_t low = w->from; low < w->to; ++low) {
+        t->res3[low] = pattern_residue(t->p3, low, 0, t->mod3);
+        t->res4[low] = pattern_residue(t->p4, low, 0, t->mod4);
+    }
+    return NULL;
+}
+
+static void mitm_add_hit(mitm_worker *w, uint64_t pattern) {
+    if (w->nhits == w->hits_cap) {
+        w->hits_cap = w->hits_cap ? w->hits_cap * 2 : 16;
+        w->hits = realloc(w->hits, w->hits_cap * sizeof(uint64_t));
+    }
+    w->hits[w->nhits++] = pattern;
+}
+
+static void *mitm_probe_worker(void *arg) {
+    mitm_worker *w = arg;
+    mitm_table *t = w->t;
+    bignum n5;
+    bignum n;
+    bignum_init(&n5);
+    bignum_init(&n);
+    for (uint64_t high = w->from; high < w->to; ++high) {
+        uint64_t h3 = pattern_residue(t->p3, high, t->split, t->mod3);
+        uint64_t h4 = pattern_residue(t->p4, high, t->split, t->mod4);
+        for (size_t v = 0; v < t->nvalid3; ++v) {
+            uint64_t want = (t->valid3[v] + t->mod3 - h3) % t->mod3;
+            for (uint32_t e = t->bucket[want]; e < t->bucket[want + 1]; ++e) {
+                mitm_entry *entry = &t->entries[e];
+                if (!only_01_digits((h4 + entry->res4) % t->mod4, 4)) {
+                    continue;
+                }
+                uint64_t pattern = (high << t->split) | entry->low;
+                if (pattern == 0) {
+                    continue;
+                }
+                bignum_from_u64(&n5, pattern);
+                bignum_base_convert(t->ctx, &n, &n5);
+                if (check_base(&n, 4) && check_base(&n, 3)) {
+                    mitm_add_hit(w, pattern);
+                }
+            }
+        }
+    }
+    bignum_free(&n5);
+    bignum_free(&n);
+    return NULL;
+}
+
+static void mitm_run(mitm_worker *workers, int nworkers, uint64_t count,
+                     void *(*fn)(void*)) {
+    uint64_t step = (count + nworkers - 1) / nworkers;
+    for (int i = 0; i < nworkers; ++i) {
+        workers[i].from = i * step < count ? i * step : count;
+        workers[i].to = (i + 1) * step < count ? (i + 1) * step : count;
+        pthread_create(&workers[i].thread, NULL, fn, &workers[i]);
+    }
+    for (int i = 0; i < nworkers; ++i) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+static int cmp_u64(void const *a, void const *b) {
+    uint64_t x = *(uint64_t const*)a;
+    uint64_t y = *(uint64_t const*)b;
+    return (x > y) - (x < y);
+}
+
+void search_mitm(mitm_opts const *opts) {
+    assert(opts->bits > 0 && opts->bits <= MITM_MAX_BITS);
+    assert(opts->split > 0 && opts->split <= MITM_MAX_SPLIT);
+    assert(opts->split < opts->bits);
+    assert(opts->workers > 0 && opts->depth >= 0);
+    int base_cap = 4;
+    mitm_table t;
+    int k3 = mitm_sieve_depth(opts);
+    int k4 = residue_digits(4, opts->split);
+    uint64_t nlow = (uint64_t)1 << opts->split;
+    t.split = opts->split;
+    t.mod3 = ipow(3, k3);
+    t.mod4 = ipow(4, k4);
+
+    t.ctx = bignum_base_ctx_new(5, 40*8);
+    for (int i = 0; i < opts->bits; ++i) {
+        t.p3[i] = bignum_mod_u64(bignum_base_ctx_power(t.ctx, i), t.mod3);
+        t.p4[i] = bignum_mod_u64(bignum_base_ctx_power(t.ctx, i), t.mod4);
+    }
+    t.nvalid3 = (size_t)1 << k3;
+    t.valid3 = malloc(t.nvalid3 * sizeof(uint32_t));
+    for (size_t v = 0; v < t.nvalid3; ++v) {
+        // read the bits of v as base 3 digits
+        t.valid3[v] = 0;
+        for (int d = k3 - 1; d >= 0; --d) {
+            t.valid3[v] = t.valid3[v] * 3 + ((v >> d) & 1);
+        }
+    }
+
+    mitm_worker *workers = calloc(opts->workers, sizeof(mitm_worker));
+    for (int i = 0; i < opts->workers; ++i) {
+        workers[i].t = &t;
+    }
+    t.res3 = malloc(nlow * sizeof(uint32_t));
+    t.res4 = malloc(nlow * sizeof(uint32_t));
+    mitm_run(workers, opts->workers, nlow, mitm_build_worker);
+
+    // counting sort of the low halves by their base 3 residue
+    t.bucket = calloc(t.mod3 + 1, sizeof(uint32_t));
+    t.entries = malloc(nlow * sizeof(mitm_entry));
+    for (uint64_t low = 0; low < nlow; ++low) {
+        ++t.bucket[t.res3[low] + 1];
+    }
+    for (uint64_t r = 0; r < t.mod3; ++r) {
+        t.bucket[r + 1] += t.bucket[r];
+    }
+    for (uint64_t low = 0; low < nlow; ++low) {
+        // bucket[r] is the fill cursor of r here, shifted back below
+        uint32_t at = t.bucket[t.res3[low]]++;
+        t.entries[at].low = low;
+        t.entries[at].res4 = t.res4[low];
+    }
+    for (uint64_t r = t.mod3; r > 0; --r) {
+        t.bucket[r] = t.bucket[r - 1];
+    }
+    t.bucket[0] = 0;
+    free(t.res3);
+    free(t.res4);
+    t.res3 = NULL;
+    t.res4 = NULL;
+
+    uint64_t nhigh = (uint64_t)1 << (opts->bits - opts->split);
+    mitm_run(workers, opts->workers, nhigh, mitm_probe_worker);
+
+    size_t nhits = 0;
+    for (int i = 0; i < opts->workers; ++i) {
+        nhits += workers[i].nhits;
+    }
+    uint64_t *hits = malloc((nhits + 1) * sizeof(uint64_t));
+    nhits = 0;
+    for (int i = 0; i < opts->workers; ++i) {
+        memcpy(hits + nhits, workers[i].hits,
+               workers[i].nhits * sizeof(uint64_t));
+        nhits += workers[i].nhits;
+        free(workers[i].hits);
+    }
+    qsort(hits, nhits, sizeof(uint64_t), cmp_u64);
+    bignum n5;
+    bignum n;
+    bignum_init(&n5);
+    bignum_init(&n);
+    for (size_t i = 0; i < nhits; ++i) {
+        bignum_from_u64(&n5, hits[i]);
+        bignum_base_convert(t.ctx, &n, &n5);
+        search_emit_hit(opts->sink, base_cap, &n);
+    }
+    bignum_free(&n5);
+    bignum_free(&n);
+    free(hits);
+    free(workers);
+    free(t.valid3);
+    free(t.bucket);
+    free(t.entries);
+    bignum_base_ctx_free(t.ctx);
+}
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "msd.h"
+
+#define TWO_64 18446744073709551616.0L
+
+void msd_table_init(msd_table *t, int base, int npowers) {
+    t->base = base;
+    t->npowers = npowers;
+    bignum_chunk_pow(base, &t->digits);
+    t->pow = malloc(npowers * sizeof(long double));
+    t->error = malloc(npowers * sizeof(long double));
+    t->pow[0] = 1;
+    t->error[0] = 0;
+    for (int i = 1; i < npowers; ++i) {
+        // exact while the power fits in the 64 bit mantissa, after that
+        // every multiplication rounds once more
+        t->pow[i] = t->pow[i - 1] * base;
+        t->error[i] = t->pow[i] < TWO_64 ? 0
+            : t->error[i - 1] + MSD_ROUNDING_ERROR;
+    }
+}
+
+void msd_table_free(msd_table *t) {
+    free(t->pow);
+    free(t->error);
+    t->pow = NULL;
+    t->error = NULL;
+}
+
+// Number of base digits of a number x within relative error, 0 if unsure
+static int msd_ndigits(msd_table const *t, long double x, long double error) {
+    // smallest d with base**d > x
+    int lo = 1;
+    int hi = t->npowers;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (t->pow[mid] > x) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    int d = lo;
+    if (d == t->npowers) {
+        return 0;
+    }
+    // base**(d-1) <= x < base**d must hold for the exact values as well;
+    // the extra rounding error covers the products below
+    error += MSD_ROUNDING_ERROR;
+    if (x * (1 + error) >= t->pow[d] * (1 - t->error[d])) {
+        return 0;
+    }
+    if (x * (1 - error) < t->pow[d - 1] * (1 + t->error[d - 1])) {
+        return 0;
+    }
+    return d;
+}
+
+// Bounds of the leading 'count' digits of x as a number, false if unsure
+static bool msd_leading(msd_table const *t, long double x, long double error,
+                        int ndigits, int count, uint64_t *min, uint64_t *max) {
+    int shift = ndigits - count;
+    if (shift == 0) {
+        // x < 2**32 is within far less than 1/2 of the exact integer
+        *min = *max = (uint64_t)(x + 0.5L);
+        return true;
+    }
+    long double q = x / t->pow[shift];
+    // x, the power and the division each contribute, the constant covers
+    // the rounding of q -/+ slack
+    long double slack = q * (error + t->error[shift] + MSD_ROUNDING_ERROR)
+        + 1e-9L;
+    if (q - slack < 0) {
+        return false;
+    }
+    *min = (uint64_t)(q - slack);
+    *max = (uint64_t)(q + slack);
+    // ndigits holds for x, so the leading digits are below base**count
+    if (*max >= (uint64_t)t->pow[count]) {
+        *max = (uint64_t)t->pow[count] - 1;
+    }
+    return *min <= *max;
+}
+
+// Smallest number >= a with 'count' digits of 0/1 only, base**count if
+// there is none
+static uint64_t msd_next_valid(uint64_t a, uint32_t base, int count) {
+    uint64_t digit[32];
+    for (int i = 0; i < count; ++i) {
+        digit[i] = a % base;
+        a /= base;
+    }
+    // the top digit above 1 goes to 0 with everything below it, and the
+    // 0/1 digits above it count up by one like a binary number
+    int top = count - 1;
+    while (top >= 0 && digit[top] <= 1) {
+        --top;
+    }
+    if (top >= 0) {
+        for (int i = 0; i <= top; ++i) {
+            digit[i] = 0;
+        }
+        int i = top + 1;
+        while (i < count && digit[i] == 1) {
+            digit[i++] = 0;
+        }
+        if (i == count) {
+            uint64_t v = 1;
+            for (int j = 0; j < count; ++j) {
+                v *= base;
+            }
+            return v;
+        }
+        digit[i] = 1;
+    }
+    uint64_t v = 0;
+    for (int i = count - 1; i >= 0; --i) {
+        v = v * base + digit[i];
+    }
+    return v;
+}
+
+// True if no number in [lo, hi] has only 0/1 among its leading digits; lo
+// and hi carry the given relative error. With lo == hi this is a leading
+// digit test of a single number.
+bool msd_block_rejects(msd_table const *t, long double lo, long double hi,
+                       long double error) {
+    assert(lo <= hi);
+    if (!MSD_EXACT) {
+        return false;
+    }
+    int ndigits = msd_ndigits(t, lo, error);
+    if (ndigits == 0 || ndigits != msd_ndigits(t, hi, error)) {
+        return false;
+    }
+    int count = ndigits < t->digits ? ndigits : t->digits;
+    uint64_t lo_min, lo_max, hi_min, hi_max;
+    if (!msd_leading(t, lo, error, ndigits, count, &lo_min, &lo_max)
+            || !msd_leading(t, hi, error, ndigits, count, &hi_min, &hi_max)) {
+        return false;
+    }
+    // the leading digits of the block lie somewhere in [lo_min, hi_max]
+    return msd_next_valid(lo_min, t->base, count) > hi_max;
+}
+
+// Rounds n from its top 9 bytes, at least 65 significant bits, so within
+// MSD_ROUNDING_ERROR
+long double msd_from_bignum(bignum const *n) {
+    long double x = 0;
+    size_t top = n->size;
+    size_t low = top > 9 ? top - 9 : 0;
+    for (size_t i = top; i > low; --i) {
+        x = x * 256 + n->data[i - 1];
+    }
+    for (size_t i = low; i > 0; --i) {
+        x *= 256;
+    }
+    return x;
+}
+
+// Cascade filter over msd_block candidates, arg is the msd_table. Passes
+// the blocks that can not be rejected as a whole.
+size_t msd_filter_block(void *candidates, size_t count, void const *arg) {
+    msd_block *b = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!msd_block_rejects(arg, b[i].lo, b[i].hi, b[i].error)) {
+            b[kept++] = b[i];
+        }
+    }
+    return kept;
+}
@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "bignum.h"
+#include "ring.h"
+#include "search.h"
+#include "pipeline.h"
+
+#define CANDIDATE_BYTES 24
+
+enum {
+    CANDIDATE_CHECK,    // n still has to pass the remaining bases
+    CANDIDATE_PROGRESS, // n5 grew by a byte, print it in order with the hits
+    CANDIDATE_END,      // no more records, shut the stage down
+};
+
+typedef struct _candidate {
+    uint8_t kind;
+    uint8_t n_size;
+    uint8_t n5_size;
+    uint8_t n[CANDIDATE_BYTES];
+    uint8_t n5[SEARCH_MAX_LIMIT_BYTES];
+} candidate;
+
+typedef struct _stage {
+    pthread_t thread;
+    ring *in;
+    ring *out; // NULL for the last stage, which prints instead
+    int base;
+    int base_cap;
+    int cpu;
+    pipeline_opts const *opts;
+} stage;
+
+void pipeline_opts_default(pipeline_opts *opts) {
+    opts->depth = PIPELINE_DEFAULT_DEPTH;
+    opts->batch = PIPELINE_DEFAULT_BATCH;
+    opts->pin = true;
+    opts->limit_bytes = SEARCH_LIMIT_BYTES;
+    opts->sink = &search_sink_stdout;
+}
+
+static void pin_to_core(int cpu) {
+#ifdef __linux__
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % ncpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+static void candidate_from_bignum(uint8_t *dst, uint8_t *dst_size,
+                                  size_t cap, bignum *src) {
+    assert(src->size <= cap);
+    memcpy(dst, src->data, src->size);
+    memset(dst + src->size, 0, cap - src->size); // bignum_to_int reads 4 bytes
+    *dst_size = src->size;
+}
+
+// Borrows the record's bytes, the view must not be freed
+static void candidate_view(bignum *view, candidate *c) {
+    view->data = c->n;
+    view->size = c->n_size;
+    view->cap = CANDIDATE_BYTES;
+    view->negative = false;
+}
+
+static void emit_candidate(candidate *c, int base_cap,
+                           search_sink const *sink) {
+    bignum n;
+    candidate_view(&n, c);
+    if (c->kind == CANDIDATE_CHECK) {
+        search_emit_hit(sink, base_cap, &n);
+    } else if (c->kind == CANDIDATE_PROGRESS) {
+        bignum n5;
+        bignum_init(&n5);
+        memcpy(n5.data, c->n5, c->n5_size);
+        n5.size = c->n5_size;
+        search_emit_progress(sink, &n5, &n);
+        bignum_free(&n5);
+    }
+}
+
+static void *checker_stage(void *arg) {
+    stage *st = arg;
+    size_t batch = st->opts->batch;
+    candidate *in = malloc(batch * sizeof(candidate));
+    candidate *out = malloc(batch * sizeof(candidate));
+    size_t nout = 0;
+    bool done = false;
+    // check_base_with's scratch, a record's n never outgrows it
+    bignum work;
+    bignum_init_cap(&work, CANDIDATE_BYTES);
+    if (st->opts->pin) {
+        pin_to_core(st->cpu);
+    }
+    while (!done) {
+        size_t nin = ring_pop(st->in, in, batch);
+        if (nin == 0) {
+            if (nout > 0 && st->out) {
+                ring_push_all(st->out, out, nout);
+                nout = 0;
+            }
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < nin; ++i) {
+            candidate *c = &in[i];
+            if (c->kind == CANDIDATE_CHECK) {
+                bignum n;
+                candidate_view(&n, c);
+                if (!check_base_with(&n, st->base, &work)) {
+                    continue;
+                }
+            } else if (c->kind == CANDIDATE_END) {
+                done = true;
+            }
+            if (!st->out) {
+                emit_candidate(c, st->base_cap, st->opts->sink);
+                continue;
+            }
+            out[nout++] = *c;
+            if (nout == batch) {
+                ring_push_all(st->out, out, nout);
+                nout = 0;
+            }
+        }
+    }
+    if (nout > 0 && st->out) {
+        ring_push_all(st->out, out, nout);
+    }
+    bignum_free(&work);
+    free(in);
+    free(out);
+    return NULL;
+}
+
+typedef struct _producer {
+    pthread_t thread;
+    ring *out;
+    bignum_base_ctx const *ctx;
+    pipeline_opts const *opts;
+} producer;
+
+// Converts every n5 and feeds the first checker stage. Runs on a thread of
+// its own so that pinning it leaves the caller's affinity alone.
+static void *producer_stage(void *arg) {
+    producer *p = arg;
+    pipeline_opts const *opts = p->opts;
+    if (opts->pin) {
+        pin_to_core(0);
+    }
+    bignum n5;
+    bignum n;
+    bignum_init(&n5);
+    bignum_init(&n);
+    bignum_from_int(&n5, 1);
+    int last_size = n5.size;
+    candidate *batch = malloc(opts->batch * sizeof(candidate));
+    size_t nbatch = 0;
+    while (n5.size < opts->limit_bytes) {
+        candidate *c = &batch[nbatch++];
+        bignum_base_convert(p->ctx, &n, &n5);
+        c->kind = CANDIDATE_CHECK;
+        candidate_from_bignum(c->n, &c->n_size, CANDIDATE_BYTES, &n);
+        bignum_inc(&n5);
+        if (n5.size > last_size) {
+            if (nbatch == opts->batch) {
+                ring_push_all(p->out, batch, nbatch);
+                nbatch = 0;
+            }
+            c = &batch[nbatch++];
+            c->kind = CANDIDATE_PROGRESS;
+            candidate_from_bignum(c->n5, &c->n5_size, SEARCH_MAX_LIMIT_BYTES,
+                                  &n5);
+            bignum_base_convert(p->ctx, &n, &n5);
+            candidate_from_bignum(c->n, &c->n_size, CANDIDATE_BYTES, &n);
+            last_size = n5.size;
+        }
+        if (nbatch == opts->batch) {
+            ring_push_all(p->out, batch, nbatch);
+            nbatch = 0;
+        }
+    }
+    if (nbatch == opts->batch) {
+        ring_push_all(p->out, batch, nbatch);
+        nbatch = 0;
+    }
+    batch[nbatch++].kind = CANDIDATE_END;
+    ring_push_all(p->out, batch, nbatch);
+    free(batch);
+    bignum_free(&n5);
+    bignum_free(&n);
+    return NULL;
+}
+
+// Same walk as search_run(), but conversion and each base check run as separate
+// stages on their own threads, connected by SPSC rings. Hits and progress
+// lines travel through every stage, so output order matches search_run().
+void search_pipelined(pipeline_opts const *opts) {
+    assert(opts->limit_bytes >= 2 && opts->limit_bytes <= SEARCH_MAX_LIMIT_BYTES);
+    assert(opts->depth > 0 && opts->batch > 0);
+    int base_cap = 4;
+    int nstages = base_cap - 2;
+    ring *rings = malloc(nstages * sizeof(ring));
+    stage *stages = malloc(nstages * sizeof(stage));
+    for (int i = 0; i < nstages; ++i) {
+        if (!ring_init(&rings[i], opts->depth, sizeof(candidate))) {
+            fprintf(stderr, "pipeline: can't allocate ring of %zu\n",
+                    opts->depth);
+            exit(1);
+        }
+    }
+    bignum_base_ctx *ctx = bignum_base_ctx_new(5, 40*8);
+    for (int i = 0; i < nstages; ++i) {
+        stage *st = &stages[i];
+        st->in = &rings[i];
+        st->out = i + 1 < nstages ? &rings[i + 1] : NULL;
+        st->base = base_cap - i;
+        st->base_cap = base_cap;
+        st->cpu = i + 1;
+        st->opts = opts;
+        pthread_create(&st->thread, NULL, checker_stage, st);
+    }
+    producer p = { .out = &rings[0], .ctx = ctx, .opts = opts };
+    pthread_create(&p.thread, NULL, producer_stage, &p);
+
+    pthread_join(p.thread, NULL);
+    for (int i = 0; i < nstages; ++i) {
+        pthread_join(stages[i].thread, NULL);
+    }
+    for (int i = 0; i < nstages; ++i) {
+        ring_free(&rings[i]);
+    }
+    free(rings);
+    free(stages);
+    bignum_base_ctx_free(ctx);
+}
@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "ring.h"
+
+// depth is rounded up to a power of two so that indices can be masked
+bool ring_init(ring *r, size_t depth, size_t elem_size) {
+    size_t cap = 1;
+    while (cap < depth) {
+        cap <<= 1;
+    }
+    memset(r, 0, sizeof(*r));
+    r->mask = cap - 1;
+    r->elem_size = elem_size;
+    if (posix_memalign((void**)&r->slots, CACHE_LINE, cap * elem_size) != 0) {
+        r->slots = NULL;
+        return false;
+    }
+    return true;
+}
+
+void ring_free(ring *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+static void ring_copy_in(ring *r, size_t at, void const *elems, size_t count) {
+    unsigned char const *src = elems;
+    for (size_t i = 0; i < count; ++i) {
+        size_t slot = (at + i) & r->mask;
+        memcpy(r->slots + slot * r->elem_size, src + i * r->elem_size,
+               r->elem_size);
+    }
+}
+
+static void ring_copy_out(ring *r, size_t at, void *elems, size_t count) {
+    unsigned char *dst = elems;
+    for (size_t i = 0; i < count; ++i) {
+        size_t slot = (at + i) & r->mask;
+        memcpy(dst + i * r->elem_size, r->slots + slot * r->elem_size,
+               r->elem_size);
+    }
+}
+
+// Pushes up to count records without blocking, returns how many were pushed.
+// The whole batch is published with a single release store of head.
+size_t ring_push(ring *r, void const *elems, size_t count) {
+    size_t head = r->head;
+    size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    size_t room = r->mask + 1 - (head - tail);
+    if (count > room) {
+        count = room;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    ring_copy_in(r, head, elems, count);
+    __atomic_store_n(&r->head, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+// Pops up to max records without blocking, returns how many were popped.
+size_t ring_pop(ring *r, void *elems, size_t max) {
+    size_t tail = r->tail;
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t avail = head - tail;
+    if (max > avail) {
+        max = avail;
+    }
+    if (max == 0) {
+        return 0;
+    }
+    ring_copy_out(r, tail, elems, max);
+    __atomic_store_n(&r->tail, tail + max, __ATOMIC_RELEASE);
+    return max;
+}
+
+// Pushes all records, yielding while the consumer catches up
+void ring_push_all(ring *r, void const *elems, size_t count) {
+    unsigned char const *src = elems;
+    while (count > 0) {
+        size_t pushed = ring_push(r, src, count);
+        if (pushed == 0) {
+            sched_yield();
+        }
+        src += pushed * r->elem_size;
+        count -= pushed;
+    }
+}
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bignum.h"
+#include "cascade.h"
+#include "msd.h"
+#include "search.h"
+
+char* unlimited_precision_base_conv(bignum *number, size_t base) {
+    static char base_digits[] = {
+        '0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+    };
+    bignum work;
+    bignum_init(&work);
+    bignum_copy(&work, number);
+    // allocate enough to print binary:
+    char *buff = malloc((work.size * 8 + 1) * sizeof(char));
+    int *converted_number = malloc((work.size * 8) * sizeof(int));
+    int digit = 0;
+    // convert to the indicated base
+    while (!bignum_is_zero(&work)) {
+        bignum_div_mod_int(&work, base, &(converted_number[digit]));
+        ++digit;
+    }
+    // now print the result in reverse order
+    --digit;  // back up to last entry in the array
+    int i = 0;
+    while (digit >= 0) {
+        buff[i] = base_digits[converted_number[digit]];
+        --digit;
+        ++i;
+    }
+    buff[i] = '\0';
+    bignum_free(&work);
+    free(converted_number);
+    return buff;
+}
+
+// check_base on a work number of the caller's, at least n->size bytes,
+// so that nothing is allocated
+bool check_base_with(bignum *n, int base, bignum *work) {
+    assert(work->cap >= n->size);
+    memcpy(work->data, n->data, n->size);
+    work->size = n->size;
+    int converted_digit = 0;
+    while (!bignum_is_zero(work)) {
+        bignum_div_mod_int(work, base, &converted_digit);
+        if (converted_digit > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_base(bignum *n, int base) {
+    bignum work;
+    bignum_init_cap(&work, n->cap);
+    bool ok = check_base_with(n, base, &work);
+    bignum_free(&work);
+    return ok;
+}
+
+static int const filter_bases[SEARCH_MAX_BASE + 1] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+};
+static char const *const residue_names[] = {
+    "res0", "res1", "res2", "res3", "res4", "res5",
+    "res6", "res7", "res8", "res9", "res10",
+};
+static char const *const full_names[] = {
+    "full0", "full1", "full2", "full3", "full4", "full5",
+    "full6", "full7", "full8", "full9", "full10",
+};
+static char const *const msd_names[] = {
+    "msd0", "msd1", "msd2", "msd3", "msd4", "msd5",
+    "msd6", "msd7", "msd8", "msd9", "msd10",
+};
+static char const *const block_names[] = {
+    "blk0", "blk1", "blk2", "blk3", "blk4", "blk5",
+    "blk6", "blk7", "blk8", "blk9", "blk10",
+};
+
+// tables[base] for every base from 3 to base_cap
+void search_msd_tables_init(msd_table *tables, int base_cap) {
+    assert(base_cap <= SEARCH_MAX_BASE);
+    for (int base = 3; base <= base_cap; ++base) {
+        msd_table_init(&tables[base], base, SEARCH_MSD_POWERS);
+    }
+}
+
+void search_msd_tables_free(msd_table *tables, int base_cap) {
+    for (int base = 3; base <= base_cap; ++base) {
+        msd_table_free(&tables[base]);
+    }
+}
+
+// Adds the checks for bases base_cap down to 3. Powers of two only get the
+// full check, which is a bit mask test there; any other base also gets a
+// residue test of its lowest digits and a test of its leading digits
+// against tables[base], both cheaper than a full check.
+void search_add_filters(cascade *c, int base_cap, filter_fn residue,
+                        filter_fn full, filter_fn msd,
+                        msd_table const *tables) {
+    assert(base_cap <= SEARCH_MAX_BASE);
+    for (int base = base_cap; base > 2; --base) {
+        if (base & (base - 1)) {
+            cascade_add(c, residue_names[base], residue, &filter_bases[base]);
+            cascade_add(c, msd_names[base], msd, &tables[base]);
+        }
+        cascade_add(c, full_names[base], full, &filter_bases[base]);
+    }
+}
+
+// Adds leading digit tests of msd_block candidates for bases base_cap down
+// to 3, a block passes if none of them can reject it as a whole.
+void search_add_block_filters(cascade *c, int base_cap,
+                              msd_table const *tables) {
+    assert(base_cap <= SEARCH_MAX_BASE);
+    for (int base = base_cap; base > 2; --base) {
+        cascade_add(c, block_names[base], msd_filter_block, &tables[base]);
+    }
+}
+
+static void bignum_swap(bignum *a, bignum *b) {
+    bignum t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Survivors are swapped to the front so that every bignum keeps its buffer
+static size_t bignum_filter_full(void *candidates, size_t count,
+                                 void const *arg) {
+    bignum *n = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (check_base(&n[i], *(int const*)arg)) {
+            bignum_swap(&n[kept++], &n[i]);
+        }
+    }
+    return kept;
+}
+
+// Tests only the lowest digits, as many as fit in 32 bits
+bool check_residue(bignum *n, int base) {
+    int digits;
+    uint64_t pow = bignum_chunk_pow(base, &digits);
+    uint64_t r = bignum_mod_u64(n, pow);
+    for (int i = 0; i < digits; ++i) {
+        if (r % base > 1) {
+            return false;
+        }
+        r /= base;
+    }
+    return true;
+}
+
+static size_t bignum_filter_residue(void *candidates, size_t count,
+                                    void const *arg) {
+    bignum *n = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (check_residue(&n[i], *(int const*)arg)) {
+            bignum_swap(&n[kept++], &n[i]);
+        }
+    }
+    return kept;
+}
+
+static size_t bignum_filter_msd(void *candidates, size_t count,
+                                void const *arg) {
+    bignum *n = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        long double x = msd_from_bignum(&n[i]);
+        if (!msd_block_rejects(arg, x, x, MSD_ROUNDING_ERROR)) {
+            bignum_swap(&n[kept++], &n[i]);
+        }
+    }
+    return kept;
+}
+
+// search_add_filters over arrays of bignum
+void search_add_bignum_filters(cascade *c, int base_cap,
+                               msd_table const *tables) {
+    search_add_filters(c, base_cap, bignum_filter_residue, bignum_filter_full,
+                       bignum_filter_msd, tables);
+}
+
+static void print_hit(void *user, int base_cap, bignum *n) {
+    printf("covers all bases from 2 to %d: ", base_cap + 1);
+    bignum_print_int(n);
+}
+
+static void print_progress(void *user, bignum *n5, bignum *n) {
+    printf("b5: ");
+    bignum_dump(n5);
+    char* b = unlimited_precision_base_conv(n, 10);
+    printf("b10: %s\n", b);
+    free(b);
+}
+
+static void print_stats(void *user, cascade const *c) {
+    cascade_report(c, stderr);
+}
+
+search_sink const search_sink_stdout = {
+    print_hit, print_progress, print_stats, NULL,
+};
+
+search_sink const search_sink_quiet = {NULL, NULL, NULL, NULL};
+
+void search_emit_hit(search_sink const *sink, int base_cap, bignum *n) {
+    if (sink->hit) {
+        sink->hit(sink->user, base_cap, n);
+    }
+}
+
+void search_emit_progress(search_sink const *sink, bignum *n5, bignum *n) {
+    if (sink->progress) {
+        sink->progress(sink->user, n5, n);
+    }
+}
+
+void search_emit_stats(search_sink const *sink, cascade const *c) {
+    if (sink->stats) {
+        sink->stats(sink->user, c);
+    }
+}
+
+void search_opts_default(search_opts *opts) {
+    opts->limit_bytes = SEARCH_LIMIT_BYTES;
+    opts->cascade_period = CASCADE_DEFAULT_PERIOD;
+    opts->sink = &search_sink_stdout;
+}
+
+// search_run's walk on bignums, for n wider than the fixed widths. Only
+// the tests call it directly.
+void search_bignum(bignum_base_ctx const *ctx, int base_cap,
+                   search_opts const *opts) {
+    bignum n5;
+    bignum n;
+    bignum tmp;
+    bignum_init(&n5);
+    bignum_init(&n);
+    bignum_init(&tmp);
+    msd_table tables[SEARCH_MAX_BASE + 1];
+    search_msd_tables_init(tables, base_cap);
+    cascade filters;
+    cascade_init(&filters, opts->cascade_period);
+    search_add_bignum_filters(&filters, base_cap, tables);
+    bignum_from_int(&n5, 1);
+    int last_size = n5.size;
+    while (n5.size < opts->limit_bytes) {
+        bignum_base_convert(ctx, &n, &n5);
+        if (cascade_run(&filters, &n, 1)) {
+            bignum_base_convert(ctx, &tmp, &n5);
+            search_emit_hit(opts->sink, base_cap, &tmp);
+        }
+        bignum_inc(&n5);
+        if (n5.size > last_size) {
+            bignum_base_convert(ctx, &tmp, &n5);
+            search_emit_progress(opts->sink, &n5, &tmp);
+            last_size = n5.size;
+        }
+    }
+    search_emit_stats(opts->sink, &filters);
+    search_msd_tables_free(tables, base_cap);
+    bignum_free(&n5);
+    bignum_free(&n);
+    bignum_free(&tmp);
+}
+
+void search_run(search_opts const *opts) {
+    assert(opts->limit_bytes >= 2 && opts->limit_bytes <= SEARCH_MAX_LIMIT_BYTES);
+    int base_cap = 4;
+    bignum_base_ctx *ctx = bignum_base_ctx_new(5, 40*8);
+    // every n stays below 5**(bits of the largest n5)
+    bignum const *top = bignum_base_ctx_power(ctx, 8 * (opts->limit_bytes - 1));
+    if (!search_fixed(ctx, top->size * 8, base_cap, opts)) {
+        search_bignum(ctx, base_cap, opts);
+    }
+    bignum_base_ctx_free(ctx);
+}
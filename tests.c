@@ -1,7 +1,24 @@
+#define _GNU_SOURCE
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "bignum.h"
+#include "cascade.h"
+#include "estimate.h"
+#include "fixed.h"
+#include "leapfrog.h"
+#include "lib82k.h"
+#include "mitm.h"
+#include "msd.h"
+#include "pipeline.h"
+#include "ring.h"
+#include "search.h"
+#include "tune.h"
 
 void test_bignum_lte() {
     bignum a, b;
@@ -17,6 +34,13 @@ void test_bignum_lte() {
     assert(bignum_lte(&a, &b) == true);
     bignum_from_int(&a, 3);
     assert(bignum_lte(&a, &b) == false);
+    // a lower byte must not decide once a higher one already has
+    bignum_from_int(&a, 0x0102);
+    bignum_from_int(&b, 0x0201);
+    assert(bignum_lte(&a, &b) == true);
+    assert(bignum_cmp(&a, &b) == -1);
+    assert(bignum_cmp(&b, &a) == 1);
+    assert(bignum_cmp(&a, &a) == 0);
     bignum_free(&a);
     bignum_free(&b);
 }
@@ -93,6 +117,72 @@ void test_bignum_from_string_binary() {
     bignum_free(&fs);
 }
 
+void test_bignum_from_string() {
+    bignum fs;
+    bignum_init(&fs);
+    assert(bignum_from_string(&fs, "82000", 5, 10));
+    assert(bignum_to_int(&fs) == 82000);
+    assert(fs.size == 3);
+    assert(bignum_from_string(&fs, "14050", 5, 16));
+    assert(bignum_to_int(&fs) == 82000);
+    assert(bignum_from_string(&fs, "1R9s", 4, 36));
+    assert(bignum_to_int(&fs) == 82000);
+    assert(bignum_from_string(&fs, "zz", 2, 36));
+    assert(bignum_to_int(&fs) == 1295);
+    assert(bignum_from_string(&fs, "000", 3, 10));
+    assert(bignum_is_zero(&fs));
+    assert(bignum_from_string(&fs, "12", 2, 2) == false);
+    assert(bignum_from_string(&fs, "1-", 2, 10) == false);
+    // 5**40 spans several chunks
+    bignum p;
+    bignum_init(&p);
+    bignum_from_int(&p, 1);
+    for (int i = 0; i < 40; ++i) {
+        bignum_mul_int(&p, 5);
+    }
+    assert(bignum_from_string(&fs, "9094947017729282379150390625", 28, 10));
+    assert(fs.size == p.size);
+    for (int i = 0; i < p.size; ++i) {
+        assert(fs.data[i] == p.data[i]);
+    }
+    bignum_free(&p);
+    // a short bignum grows as the digits come in
+    bignum_free(&fs);
+    bignum_init_cap(&fs, 4);
+    assert(bignum_from_string(&fs, "10000000000000000000000000000000000", 35,
+                              16));
+    assert(fs.size == 18);
+    assert(fs.data[17] == 1); // 16**34 = 2**136
+    bignum_free(&fs);
+}
+
+void test_bignum_from_string_batch() {
+    char const buf[] = "82000\r\n\n1\n4294967295\nx\n7\n";
+    bignum out[4];
+    for (int i = 0; i < 4; ++i) {
+        bignum_init(&out[i]);
+    }
+    size_t end = 0;
+    size_t count = bignum_from_string_batch(out, 4, buf, sizeof(buf) - 1, 10,
+                                            &end);
+    assert(count == 3);
+    assert(bignum_to_int(&out[0]) == 82000);
+    assert(bignum_to_int(&out[1]) == 1);
+    assert((unsigned)bignum_to_int(&out[2]) == 4294967295u);
+    assert(buf[end] == 'x');
+    count = bignum_from_string_batch(out, 4, buf + end + 2,
+                                     sizeof(buf) - 1 - end - 2, 10, &end);
+    assert(count == 1);
+    assert(bignum_to_int(&out[0]) == 7);
+    // out fills up before the buffer runs out
+    count = bignum_from_string_batch(out, 1, "1\n2\n", 4, 10, &end);
+    assert(count == 1);
+    assert(end == 2);
+    for (int i = 0; i < 4; ++i) {
+        bignum_free(&out[i]);
+    }
+}
+
 void eyeball_tests() {
     bignum n;
     bignum_init(&n);
@@ -183,34 +273,98 @@ void test_bignum_from_bignum() {
     bignum bn2;
     bignum_init(&bn);
     bignum_init(&bn2);
-    bignum_init_base_convert(40*8, 2);
+    // both contexts are live at once, nothing is torn down in between
+    bignum_base_ctx *ctx2 = bignum_base_ctx_new(2, 40*8);
+    bignum_base_ctx *ctx5 = bignum_base_ctx_new(5, 40*8);
+    assert(bignum_base_ctx_base(ctx2) == 2);
+    assert(bignum_base_ctx_base(ctx5) == 5);
+    assert(bignum_base_ctx_size(ctx5) == 40*8);
     bignum_from_int(&bn, 1047);
-    bignum_base_convert(&bn2, &bn);
+    bignum_base_convert(ctx2, &bn2, &bn);
     assert(bn2.size == 2);
     assert(bn2.data[0] == 23);
     assert(bn2.data[1] == 4);
-    bignum_free_base_convert_lut();
     //
-    bignum_init_base_convert(40*8, 5);
     bignum_from_int(&bn, 1);
-    bignum_base_convert(&bn2, &bn);
+    bignum_base_convert(ctx5, &bn2, &bn);
     assert(bn2.size == 1);
     assert(bn2.data[0] == 1);
     bignum_from_int(&bn, 2); // binary 10
-    bignum_base_convert(&bn2, &bn);
+    bignum_base_convert(ctx5, &bn2, &bn);
     assert(bn2.size == 1);
     assert(bn2.data[0] == 5);
     bignum_from_int(&bn, 3); // binary 11
-    bignum_base_convert(&bn2, &bn);
+    bignum_base_convert(ctx5, &bn2, &bn);
     assert(bn2.size == 1);
     assert(bn2.data[0] == 6);
+    bignum_base_convert(ctx2, &bn2, &bn);
+    assert(bn2.size == 1);
+    assert(bn2.data[0] == 3);
     bignum_from_int(&bn, 5); // binary 101
-    bignum_base_convert(&bn2, &bn);
+    bignum_base_convert(ctx5, &bn2, &bn);
     assert(bn2.size == 1);
     assert(bn2.data[0] == 26);
+    assert(bignum_base_ctx_power(ctx5, 3)->size == 1);
+    assert(bignum_base_ctx_power(ctx5, 3)->data[0] == 125);
     bignum_free(&bn);
     bignum_free(&bn2);
-    bignum_free_base_convert_lut();
+    bignum_base_ctx_free(ctx2);
+    bignum_base_ctx_free(ctx5);
+}
+
+static bool only_01_digits(int x, int base) {
+    for (; x > 0; x /= base) {
+        if (x % base > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_bignum_next_ge() {
+    bignum x, r, work, digits;
+    bignum_init(&x);
+    bignum_init(&r);
+    bignum_init(&work);
+    bignum_init(&digits);
+    for (int base = 3; base <= 5; ++base) {
+        bignum_base_ctx *ctx = bignum_base_ctx_new(base, 40*8);
+        for (int i = 1; i < 3000; ++i) {
+            int want = i;
+            while (!only_01_digits(want, base)) {
+                ++want;
+            }
+            bignum_from_int(&x, i);
+            assert(bignum_next_ge(ctx, &r, &x, &work, &digits));
+            assert(bignum_to_int(&r) == want);
+        }
+        bignum_base_ctx_free(ctx);
+    }
+    // 3**64 - 1 is all 2s, rounding up needs 3**64, past a table of 64
+    bignum_base_ctx *ctx = bignum_base_ctx_new(3, 64);
+    bignum_copy(&x, bignum_base_ctx_power(ctx, 63));
+    bignum_mul_int(&x, 3);
+    bignum_from_int(&r, 7);
+    bignum_from_int(&work, 1);
+    bignum_sub(&x, &work);
+    assert(!bignum_next_ge(ctx, &r, &x, &work, &digits));
+    assert(bignum_to_int(&r) == 7);
+    // 3**63 + 2 rounds up to 3**63 + 3
+    bignum small;
+    bignum_init(&small);
+    bignum_copy(&x, bignum_base_ctx_power(ctx, 63));
+    bignum_from_int(&small, 2);
+    bignum_add(&x, &small);
+    assert(bignum_next_ge(ctx, &r, &x, &work, &digits));
+    bignum_from_int(&small, 1);
+    bignum_add(&x, &small);
+    assert(bignum_cmp(&r, &x) == 0);
+    bignum_free(&small);
+    bignum_base_ctx_free(ctx);
+    bignum_free(&x);
+    bignum_free(&r);
+    bignum_free(&work);
+    bignum_free(&digits);
 }
 
 void test_bignum_mul_int() {
@@ -288,6 +442,460 @@ void test_bignum_add() {
     bignum_free(&b);
 }
 
+void test_ring() {
+    ring r;
+    int in[5] = {1, 2, 3, 4, 5};
+    int out[5] = {0};
+    assert(ring_init(&r, 3, sizeof(int)));
+    assert(r.mask == 3); // depth rounded up to 4
+    assert(ring_pop(&r, out, 5) == 0);
+    assert(ring_push(&r, in, 5) == 4);
+    assert(ring_push(&r, in, 1) == 0);
+    assert(ring_pop(&r, out, 2) == 2);
+    assert(out[0] == 1);
+    assert(out[1] == 2);
+    // wrap around the end of the slots
+    assert(ring_push(&r, &in[4], 1) == 1);
+    assert(ring_pop(&r, out, 5) == 3);
+    assert(out[0] == 3);
+    assert(out[1] == 4);
+    assert(out[2] == 5);
+    assert(ring_pop(&r, out, 5) == 0);
+    ring_free(&r);
+}
+
+// A sink that writes hits and progress into a buffer, one line each
+typedef struct _recording {
+    char buf[4096];
+    size_t len;
+} recording;
+
+static void record(recording *r, char kind, bignum *n) {
+    char *digits = unlimited_precision_base_conv(n, 10);
+    int len = snprintf(r->buf + r->len, sizeof(r->buf) - r->len, "%c %s\n",
+                       kind, digits);
+    assert(len > 0 && r->len + len < sizeof(r->buf));
+    r->len += len;
+    free(digits);
+}
+
+static void record_hit(void *user, int base_cap, bignum *n) {
+    record(user, 'h', n);
+}
+
+static void record_progress(void *user, bignum *n5, bignum *n) {
+    record(user, 'p', n);
+}
+
+static void recording_sink(search_sink *sink, recording *r) {
+    r->len = 0;
+    r->buf[0] = '\0';
+    sink->hit = record_hit;
+    sink->progress = record_progress;
+    sink->stats = NULL;
+    sink->user = r;
+}
+
+// What search_run reports for n5 shorter than limit_bytes
+static void record_search_run(recording *r, size_t limit_bytes) {
+    search_sink sink;
+    recording_sink(&sink, r);
+    search_opts opts;
+    search_opts_default(&opts);
+    opts.limit_bytes = limit_bytes;
+    opts.sink = &sink;
+    search_run(&opts);
+}
+
+void test_pipeline() {
+    recording want, got;
+    record_search_run(&want, 3);
+    assert(0 == strcmp(want.buf, "h 1\nh 82000\np 390625\n"
+                                 "p 152587890625\n"));
+    size_t const sizes[][2] = {{1, 1}, {3, 2}, {2, 64}, {4096, 64}};
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        search_sink sink;
+        recording_sink(&sink, &got);
+        pipeline_opts opts;
+        pipeline_opts_default(&opts);
+        opts.depth = sizes[i][0];
+        opts.batch = sizes[i][1];
+        opts.limit_bytes = 3;
+        opts.pin = i % 2;
+        opts.sink = &sink;
+#ifdef __linux__
+        cpu_set_t before, after;
+        pthread_getaffinity_np(pthread_self(), sizeof(before), &before);
+#endif
+        search_pipelined(&opts);
+#ifdef __linux__
+        // pinning is the stages' business, the caller keeps its cpus
+        pthread_getaffinity_np(pthread_self(), sizeof(after), &after);
+        assert(CPU_EQUAL(&before, &after));
+#endif
+        assert(0 == strcmp(want.buf, got.buf));
+    }
+}
+
+void test_search_run_limits() {
+    for (size_t limit = 2; limit <= SEARCH_MAX_LIMIT_BYTES; ++limit) {
+        recording r;
+        record_search_run(&r, limit);
+        assert(0 == strncmp(r.buf, "h 1\nh 82000\np ", 14));
+        // one progress line for every length n5 grows to
+        size_t lines = 0;
+        for (char const *c = r.buf; *c; ++c) {
+            lines += *c == '\n';
+        }
+        assert(lines == 2 + limit - 1);
+    }
+}
+
+void test_search_bignum() {
+    bignum_base_ctx *ctx = bignum_base_ctx_new(5, 40*8);
+    recording want, got;
+    for (size_t limit = 2; limit <= 4; ++limit) {
+        record_search_run(&want, limit);
+        search_sink sink;
+        recording_sink(&sink, &got);
+        search_opts opts;
+        search_opts_default(&opts);
+        opts.limit_bytes = limit;
+        opts.sink = &sink;
+        search_bignum(ctx, 4, &opts);
+        assert(0 == strcmp(want.buf, got.buf));
+    }
+    bignum_base_ctx_free(ctx);
+}
+
+void test_leapfrog() {
+    recording want, got;
+    for (size_t limit = 2; limit <= SEARCH_MAX_LIMIT_BYTES; ++limit) {
+        record_search_run(&want, limit);
+        search_sink sink;
+        recording_sink(&sink, &got);
+        search_opts opts;
+        search_opts_default(&opts);
+        opts.limit_bytes = limit;
+        opts.sink = &sink;
+        leapfrog_stats stats;
+        search_leapfrog(&opts, &stats);
+        assert(stats.hits == 2);
+        assert(0 == strcmp(want.buf, got.buf));
+    }
+}
+
+void test_mitm() {
+    recording want, got;
+    for (int bits = 8; bits <= 16; bits += 4) {
+        // the hits of every pattern below 2**bits, as search_mitm prints them
+        want.len = 0;
+        uint64_t hits[16];
+        size_t nhits;
+        assert(k82_search_range(5, 1, (uint64_t)1 << bits, K82_BASES_TO(4),
+                                NULL, hits, 16, &nhits) == K82_OK);
+        assert(nhits >= 2 && nhits <= 16);
+        for (size_t i = 0; i < nhits; ++i) {
+            uint64_t value;
+            size_t used;
+            assert(k82_pattern_value(5, hits[i], &value, 1, &used) == K82_OK);
+            want.len += snprintf(want.buf + want.len,
+                                 sizeof(want.buf) - want.len, "h %llu\n",
+                                 (unsigned long long)value);
+        }
+        int const splits[] = {1, bits / 2, bits - 1};
+        for (int s = 0; s < 3; ++s) {
+            for (int workers = 1; workers <= 3; workers += 2) {
+                // the deepest sieve, a single base 3 digit and one past
+                // the deepest, which is clamped
+                for (int depth = 0; depth <= 20; depth += depth ? 19 : 1) {
+                    search_sink sink;
+                    recording_sink(&sink, &got);
+                    mitm_opts opts;
+                    mitm_opts_default(&opts);
+                    opts.bits = bits;
+                    opts.split = splits[s];
+                    opts.workers = workers;
+                    opts.depth = depth;
+                    opts.sink = &sink;
+                    search_mitm(&opts);
+                    assert(0 == strcmp(want.buf, got.buf));
+                }
+            }
+        }
+    }
+    // 16 bits are the n5 of up to two bytes, search_run finds the same
+    recording run;
+    record_search_run(&run, 3);
+    assert(0 == strncmp(run.buf, want.buf, want.len));
+    assert(run.buf[want.len] == 'p');
+}
+
+void test_fixed() {
+    bignum n;
+    bignum_init(&n);
+    bignum_from_int(&n, 82000);
+    u128 a;
+    u192 b;
+    u256 c;
+    u128_from_bignum(&a, &n);
+    u192_from_bignum(&b, &n);
+    u256_from_bignum(&c, &n);
+    for (int base = 2; base < 6; ++base) {
+        assert(u128_check_base(&a, base) == true);
+        assert(u192_check_base(&b, base) == true);
+        assert(u256_check_base(&c, base) == true);
+    }
+    assert(u128_check_base(&a, 6) == false);
+    assert(u256_check_base(&c, 7) == false);
+    // carry across limbs, 2**64 - 1 + 1
+    u192 one, d;
+    u192_zero(&one);
+    one.l[0] = 1;
+    u192_zero(&d);
+    d.l[0] = ~0ull;
+    assert(u192_add(&d, &one) == false);
+    assert(d.l[0] == 0);
+    assert(d.l[1] == 1);
+    assert(u192_cmp(&d, &one) == 1);
+    assert(u192_cmp(&one, &d) == -1);
+    assert(u192_divmod_small(&d, 3) == 1); // 2**64 = 3 * 6148914691236517205 + 1
+    assert(d.l[0] == 6148914691236517205ull);
+    assert(d.l[1] == 0);
+    // 3 * 4**40 has a 3 in base 4 way past the first limb
+    u128_zero(&a);
+    a.l[1] = 3ull << 16;
+    assert(u128_check_base(&a, 4) == false);
+    u128_to_bignum(&n, &a);
+    assert(n.size == 11);
+    assert(n.data[10] == 3);
+    bignum_free(&n);
+}
+
+static size_t filter_below(void *candidates, size_t count, void const *arg) {
+    int *n = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (n[i] < *(int const*)arg) {
+            n[kept++] = n[i];
+        }
+    }
+    return kept;
+}
+
+static size_t filter_even(void *candidates, size_t count, void const *arg) {
+    int *n = candidates;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (n[i] % 2 == 0) {
+            n[kept++] = n[i];
+        }
+    }
+    return kept;
+}
+
+void test_cascade() {
+    cascade c;
+    int limit = 10;
+    int n[100];
+    cascade_init(&c, 0);
+    cascade_add(&c, "even", filter_even, NULL);
+    cascade_add(&c, "below", filter_below, &limit);
+    for (int i = 0; i < 100; ++i) {
+        n[i] = i;
+    }
+    assert(cascade_run(&c, n, 100) == 5);
+    for (int i = 0; i < 5; ++i) {
+        assert(n[i] == 2 * i);
+    }
+    assert(c.filters[0].calls == 100);
+    assert(c.filters[0].passes == 50);
+    assert(c.filters[1].calls == 50);
+    assert(c.filters[1].passes == 5);
+    // same cost, but below rejects 90% and even only 50%
+    c.filters[0].timed = c.filters[1].timed = 100;
+    c.filters[0].ns = c.filters[1].ns = 1000;
+    cascade_reorder(&c);
+    assert(c.order[0] == 1);
+    assert(c.order[1] == 0);
+    // a filter that rejects nothing goes last however cheap it is
+    c.filters[1].passes = c.filters[1].calls;
+    c.filters[1].ns = 1;
+    cascade_reorder(&c);
+    assert(c.order[0] == 0);
+    // and the survivors do not depend on the order
+    for (int i = 0; i < 100; ++i) {
+        n[i] = i;
+    }
+    assert(cascade_run(&c, n, 100) == 5);
+    for (int i = 0; i < 5; ++i) {
+        assert(n[i] == 2 * i);
+    }
+    // every base up to SEARCH_MAX_BASE fits, 20 filters at base 10
+    msd_table tables[SEARCH_MAX_BASE + 1];
+    search_msd_tables_init(tables, SEARCH_MAX_BASE);
+    cascade_init(&c, 0);
+    search_add_bignum_filters(&c, SEARCH_MAX_BASE, tables);
+    assert(c.nfilters == 20);
+    search_msd_tables_free(tables, SEARCH_MAX_BASE);
+}
+
+void test_msd() {
+    msd_table t3, t4;
+    msd_table_init(&t3, 3, 100);
+    msd_table_init(&t4, 4, 100);
+    long double e = MSD_ROUNDING_ERROR;
+    // 82000 = 11011111001 (base 3), 110001100 (base 4)
+    assert(!msd_block_rejects(&t3, 82000, 82000, e));
+    assert(!msd_block_rejects(&t4, 82000, 82000, e));
+    if (!MSD_EXACT) {
+        // the filter is off, not even 2*3**10 is rejected
+        assert(!msd_block_rejects(&t3, 118098, 118098, e));
+        msd_table_free(&t3);
+        msd_table_free(&t4);
+        return;
+    }
+    // 2*3**10 = 20000000000 (base 3)
+    assert(msd_block_rejects(&t3, 118098, 118098, e));
+    // the largest 11 digit 0/1 number is 11111111111 = 88573
+    assert(msd_block_rejects(&t3, 88574, 177146, e));
+    assert(!msd_block_rejects(&t3, 88573, 177146, e));
+    assert(!msd_block_rejects(&t3, 88574, 177147, e));
+    // 1102 to 1112 holds 1110, 1202 to 1222 nothing
+    assert(!msd_block_rejects(&t3, 38, 41, e));
+    assert(msd_block_rejects(&t3, 47, 53, e));
+    // 2**64 = 1 and 32 zeros, 3*2**64 = 3 and 32 zeros (base 4)
+    u128 x;
+    u128_zero(&x);
+    x.l[1] = 1;
+    assert(u128_to_ld(&x) == 18446744073709551616.0L);
+    assert(!msd_block_rejects(&t4, u128_to_ld(&x), u128_to_ld(&x), e));
+    x.l[1] = 3;
+    assert(msd_block_rejects(&t4, u128_to_ld(&x), u128_to_ld(&x), e));
+    // a 2 followed by 39 ones is out, 3**41 - 1 is 41 twos but too close
+    // to 3**41 to tell its digit count
+    bignum n;
+    bignum_init(&n);
+    char const *two_ones = "2111111111111111111111111111111111111111";
+    assert(bignum_from_string(&n, two_ones, 40, 3));
+    long double y = msd_from_bignum(&n);
+    assert(msd_block_rejects(&t3, y, y, e));
+    char const *twos = "22222222222222222222222222222222222222222";
+    assert(bignum_from_string(&n, twos, 41, 3));
+    y = msd_from_bignum(&n);
+    assert(!msd_block_rejects(&t3, y, y, e));
+    bignum_from_int(&n, 82000);
+    assert(msd_from_bignum(&n) == 82000);
+    bignum_free(&n);
+    msd_table_free(&t3);
+    msd_table_free(&t4);
+}
+
+void test_lib82k() {
+    assert(k82_api_version() == K82_API_VERSION);
+    k82_opts opts = { 3 };
+    k82_bases b345 = K82_BASES_TO(5);
+    // 84 = 10010 (base 3), 1110 (base 4), 314 (base 5); the last two are
+    // 2**64 and 3*2**64, 1 and 3 followed by 32 zeros (base 4)
+    uint64_t limbs[] = {1, 0, 82000, 0, 84, 0, 2, 0, 0, 1, 0, 3};
+    uint8_t out[6];
+    assert(k82_check_limbs(limbs, 2, 4, b345, &opts, out) == K82_OK);
+    assert(out[0] == 1 && out[1] == 1 && out[2] == 0 && out[3] == 0);
+    assert(k82_check_limbs(limbs, 2, 6, K82_BASE(4), &opts, out) == K82_OK);
+    assert(out[2] == 1 && out[3] == 0 && out[4] == 1 && out[5] == 0);
+    assert(k82_check_limbs(limbs, 2, 6, K82_BASE(11), &opts, out)
+           == K82_EINVAL);
+    char const *strs[] = {"82000", "1R9s", "84", "8x"};
+    assert(k82_check_strings(strs, 2, 36, b345, NULL, out) == K82_OK);
+    assert(out[0] == 0 && out[1] == 1);
+    assert(k82_check_strings(strs, 4, 10, b345, &opts, out) == K82_EINVAL);
+    assert(out[0] == 1 && out[1] == 0 && out[2] == 0 && out[3] == 0);
+    char const *empty[] = {"", "1"};
+    assert(k82_check_strings(empty, 2, 10, b345, NULL, out) == K82_EINVAL);
+    assert(out[0] == 0 && out[1] == 1);
+    // 82000 = 10111000 (base 5), pattern 184
+    uint64_t hits[4];
+    size_t nhits;
+    opts.threads = 0;
+    assert(k82_search_range(5, 0, 256, K82_BASES_TO(4), &opts, hits, 4,
+                            &nhits) == K82_OK);
+    assert(nhits == 3 && hits[0] == 0 && hits[1] == 1 && hits[2] == 184);
+    opts.threads = 7;
+    assert(k82_search_range(5, 1, 1 << 12, K82_BASES_TO(4), &opts, hits, 1,
+                            &nhits) == K82_OK);
+    assert(nhits == 2 && hits[0] == 1);
+    assert(k82_search_range(5, 2, 2, K82_BASES_TO(4), &opts, hits, 4,
+                            &nhits) == K82_OK);
+    assert(nhits == 0);
+    size_t used;
+    assert(k82_pattern_value(5, 184, limbs, 2, &used) == K82_OK);
+    assert(used == 1 && limbs[0] == 82000 && limbs[1] == 0);
+    assert(k82_pattern_value(5, 1ull << 63, limbs, 1, &used) == K82_EINVAL);
+    assert(used == 3);
+}
+
+void test_estimate() {
+    estimate_opts opts;
+    estimate_opts_default(&opts);
+    opts.limit_bytes = 3;
+    opts.workers = 2;
+    opts.samples = 64;
+    opts.mitm.bits = 16;
+    opts.mitm.split = 8;
+    estimate e;
+    estimate_run(&opts, &e);
+    assert(e.nrows == 2);
+    // 11111111 (base 5) = 97656 takes 17 bits, sixteen ones take 36
+    assert(e.rows[0].n5_bytes == 1 && e.rows[0].candidates == 255);
+    assert(e.rows[0].n_bits == 17);
+    assert(e.rows[1].n5_bytes == 2 && e.rows[1].candidates == 65280);
+    assert(e.rows[1].n_bits == 36);
+    // the one byte patterns include the hits, so nothing is skipped there
+    assert(e.rows[0].skipped == 0);
+    assert(e.rows[0].filters.candidates == 64);
+    assert(e.cpu_hours > 0 && e.cpu_hours_skipping <= e.cpu_hours);
+    // the first byte has no blocks, the 255 of the second are all tested
+    assert(e.rows[0].block_tests == 0 && e.rows[1].block_tests == 255);
+    assert(e.setup_ns > 0 && e.cpu_hours >= e.setup_ns / 3.6e12);
+    // both workers build the tables, the candidates are split between them
+    double setup_hours = e.setup_ns / 3.6e12;
+    assert(e.wall_hours == (e.cpu_hours_skipping - setup_hours) / 2
+           + setup_hours);
+    assert(e.width == 128 && e.table_bytes > 3 * 256 * 16);
+    assert(e.mitm_table_bytes == mitm_table_bytes(&opts.mitm));
+}
+
+void test_tune_profile() {
+    char path[] = "/tmp/82k-profile-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    tune_profile p, q;
+    tune_profile_default(&p);
+    p.pipeline_depth = 256;
+    p.pipeline_batch = 16;
+    p.mitm_split_bias = -2;
+    p.mitm_workers = 3;
+    p.mitm_depth = 5;
+    assert(tune_profile_save(&p, path));
+    tune_profile_default(&q);
+    assert(tune_profile_load(&q, path));
+    assert(q.pipeline_depth == 256);
+    assert(q.pipeline_batch == 16);
+    assert(q.mitm_split_bias == -2);
+    assert(q.mitm_workers == 3);
+    assert(q.mitm_depth == 5);
+    unlink(path);
+    assert(tune_profile_load(&q, path) == false);
+    mitm_opts m;
+    mitm_opts_default(&m);
+    m.bits = 24;
+    tune_mitm_opts(&q, &m);
+    assert(m.split == 10);
+    assert(m.workers == 3);
+    assert(m.depth == 5);
+}
+
 void test() {
     bignum n;
     bignum_init(&n);
@@ -325,11 +933,26 @@ void test() {
     test_bignum_add();
     test_bignum_mul_int();
     test_bignum_from_string_binary();
+    test_bignum_from_string();
+    test_bignum_from_string_batch();
     test_bignum_from_bignum();
     test_bignum_lte();
+    test_bignum_next_ge();
     test_bignum_sub();
     test_bignum_div_mod();
     test_bignum_div_mod_int();
     test_bignum_is_zero();
+    test_ring();
+    test_pipeline();
+    test_search_run_limits();
+    test_search_bignum();
+    test_leapfrog();
+    test_mitm();
+    test_fixed();
+    test_cascade();
+    test_tune_profile();
+    test_msd();
+    test_lib82k();
+    test_estimate();
     printf("Tests OK\n");
 }
@@ -0,0 +1,204 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "timing.h"
+#include "tune.h"
+
+#define TUNE_REPEAT 3
+
+void tune_profile_default(tune_profile *p) {
+    pipeline_opts pipeline;
+    mitm_opts mitm;
+    pipeline_opts_default(&pipeline);
+    mitm_opts_default(&mitm);
+    p->pipeline_depth = pipeline.depth;
+    p->pipeline_batch = pipeline.batch;
+    p->mitm_split_bias = 0;
+    p->mitm_workers = mitm.workers;
+    p->mitm_depth = mitm.depth;
+}
+
+// $K82_PROFILE, or ~/.82k.<hostname>.profile so that hosts sharing a home
+// directory keep separate profiles
+void tune_profile_path(char *buf, size_t len) {
+    char const *env = getenv("K82_PROFILE");
+    if (env) {
+        snprintf(buf, len, "%s", env);
+        return;
+    }
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char const *home = getenv("HOME");
+    snprintf(buf, len, "%s/.82k.%s.profile", home ? home : ".", host);
+}
+
+// Reads key=value lines, unknown keys and '#' comments are skipped.
+// Returns false if the file can't be opened, p keeps its values then.
+bool tune_profile_load(tune_profile *p, char const *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char *eq = strchr(line, '=');
+        if (line[0] == '#' || !eq) {
+            continue;
+        }
+        *eq = '\0';
+        char const *value = eq + 1;
+        if (0 == strcmp(line, "pipeline_depth")) {
+            p->pipeline_depth = strtoul(value, NULL, 10);
+        } else if (0 == strcmp(line, "pipeline_batch")) {
+            p->pipeline_batch = strtoul(value, NULL, 10);
+        } else if (0 == strcmp(line, "mitm_split_bias")) {
+            p->mitm_split_bias = atoi(value);
+        } else if (0 == strcmp(line, "mitm_workers")) {
+            p->mitm_workers = atoi(value);
+        } else if (0 == strcmp(line, "mitm_depth")) {
+            p->mitm_depth = atoi(value);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+bool tune_profile_save(tune_profile const *p, char const *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+    fprintf(f, "# written by 82k --autotune\n");
+    fprintf(f, "pipeline_depth=%zu\n", p->pipeline_depth);
+    fprintf(f, "pipeline_batch=%zu\n", p->pipeline_batch);
+    fprintf(f, "mitm_split_bias=%d\n", p->mitm_split_bias);
+    fprintf(f, "mitm_workers=%d\n", p->mitm_workers);
+    fprintf(f, "mitm_depth=%d\n", p->mitm_depth);
+    return fclose(f) == 0;
+}
+
+void tune_pipeline_opts(tune_profile const *p, pipeline_opts *opts) {
+    opts->depth = p->pipeline_depth;
+    opts->batch = p->pipeline_batch;
+}
+
+// Only sets the split if it leaves both halves non-empty
+void tune_mitm_opts(tune_profile const *p, mitm_opts *opts) {
+    int split = opts->bits / 2 + p->mitm_split_bias;
+    if (split >= 1 && split < opts->bits && split <= 30) {
+        opts->split = split;
+    }
+    if (p->mitm_workers > 0) {
+        opts->workers = p->mitm_workers;
+    }
+    if (p->mitm_depth >= 0) {
+        opts->depth = p->mitm_depth;
+    }
+}
+
+// A single run: at limit_bytes 4 it takes seconds, far above the jitter
+static double time_pipeline(pipeline_opts const *opts) {
+    uint64_t start = timing_now_ns();
+    search_pipelined(opts);
+    return (timing_now_ns() - start) / 1e9;
+}
+
+static double time_mitm(mitm_opts const *opts) {
+    double best = 1e300;
+    for (int i = 0; i < TUNE_REPEAT; ++i) {
+        uint64_t start = timing_now_ns();
+        search_mitm(opts);
+        double took = (timing_now_ns() - start) / 1e9;
+        best = took < best ? took : best;
+    }
+    return best;
+}
+
+// Runs the pipeline and mitm kernels over a short range with each
+// candidate setting, keeps the fastest and prints all of them to out.
+// search_run has nothing to tune: with block skipping its cascades see a
+// few hundred blocks and candidates, never a reorder period.
+void autotune(tune_profile *p, FILE *out) {
+    pipeline_opts pipeline;
+    pipeline_opts_default(&pipeline);
+    pipeline.sink = &search_sink_quiet;
+    pipeline.limit_bytes = 4;
+    size_t depths[] = {256, 4096, 65536};
+    size_t batches[] = {16, 64, 256};
+    double best = 1e300;
+    for (int i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+        for (int j = 0; j < sizeof(batches) / sizeof(batches[0]); ++j) {
+            pipeline.depth = depths[i];
+            pipeline.batch = batches[j];
+            double took = time_pipeline(&pipeline);
+            fprintf(out, "pipeline depth=%-6zu batch=%-4zu %.4fs\n",
+                    depths[i], batches[j], took);
+            if (took < best) {
+                best = took;
+                p->pipeline_depth = depths[i];
+                p->pipeline_batch = batches[j];
+            }
+        }
+    }
+
+    mitm_opts mitm;
+    mitm_opts_default(&mitm);
+    mitm.sink = &search_sink_quiet;
+    mitm.bits = 28;
+    int max_workers = mitm.workers;
+    best = 1e300;
+    for (int bias = -4; bias <= 4; bias += 2) {
+        mitm.split = mitm.bits / 2 + bias;
+        double took = time_mitm(&mitm);
+        fprintf(out, "mitm     split=%d workers=%d %.4fs\n", mitm.split,
+                mitm.workers, took);
+        if (took < best) {
+            best = took;
+            p->mitm_split_bias = bias;
+        }
+    }
+    mitm.split = mitm.bits / 2 + p->mitm_split_bias;
+    // powers of two below max_workers, then all of them
+    int workers[32];
+    int nworkers = 0;
+    for (int w = 1; w < max_workers; w *= 2) {
+        workers[nworkers++] = w;
+    }
+    workers[nworkers++] = max_workers;
+    best = 1e300;
+    for (int i = 0; i < nworkers; ++i) {
+        mitm.workers = workers[i];
+        double took = time_mitm(&mitm);
+        fprintf(out, "mitm     split=%d workers=%d %.4fs\n", mitm.split,
+                workers[i], took);
+        if (took < best) {
+            best = took;
+            p->mitm_workers = workers[i];
+        }
+    }
+    mitm.workers = p->mitm_workers;
+    // 0 is the deepest residue sieve the split allows. Shallower ones visit
+    // fewer residues per high half but more low halves per residue; more
+    // than two digits shallower they only lose.
+    mitm.depth = 0;
+    int deepest = mitm_sieve_depth(&mitm);
+    best = 1e300;
+    for (int depth = deepest; depth > 0 && depth >= deepest - 2; --depth) {
+        mitm.depth = depth == deepest ? 0 : depth;
+        double took = time_mitm(&mitm);
+        fprintf(out, "mitm     split=%d workers=%d depth=%d %.4fs\n",
+                mitm.split, mitm.workers, mitm.depth, took);
+        if (took < best) {
+            best = took;
+            p->mitm_depth = mitm.depth;
+        }
+    }
+    fprintf(out, "chose pipeline_depth=%zu pipeline_batch=%zu "
+            "mitm_split_bias=%d mitm_workers=%d mitm_depth=%d\n",
+            p->pipeline_depth, p->pipeline_batch, p->mitm_split_bias,
+            p->mitm_workers, p->mitm_depth);
+}